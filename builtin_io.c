@@ -173,7 +173,7 @@ static void read_int(FILE *f, int c, int base, value_tp *x, exec_info *ef)
    if (overflow)
      { x->rep = REP_z;
        x->v.z = new_z_value(ef);
-       mpz_init_set_str(x->v.z->z, ef->scratch.s, base);
+       mpz_set_str(x->v.z->z, ef->scratch.s, base);
      }
    else
      { x->rep = REP_int;
@@ -291,6 +291,7 @@ static void builtin_write_int(function_def *x, exec_info *f)
      { exec_error(f, y, "No value passed for base"); }
    fl = get_file(fval, f, y);
    base = baseval->v.i;
+   int_unwide(xval, f);
    if (xval->rep == REP_int)
      { if (xval->v.i < 0)
          { putc('-', fl);
@@ -171,7 +171,8 @@ extern exec_info *term_exec(exec_info *f)
  /* Pre: f is return value of prepare_exec().
     Free the memory.
  */
- { exec_info_term(f);
+ { report_memo(f->user);
+   exec_info_term(f);
    return 0;
  }
 
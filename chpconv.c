@@ -240,6 +240,7 @@ extern int main(int argc, char *argv[])
    FILE *outfile = 0;
    init_chpconv();
    user_info_init(U);
+   SET_FLAG(U->flags, USER_keepwu); /* wired ports are found via these */
    set_default_path(U);
    llist_init(&pl);
    while (i < argc)
@@ -366,6 +367,7 @@ extern int main(int argc, char *argv[])
 
 static void print_meta_value(value_tp *v, print_info *f)
  { int i;
+   mpz_t z;
    switch (v->rep)
      { case REP_bool:
          print_string(v->v.i? "true" : "false", f);
@@ -378,6 +380,14 @@ static void print_meta_value(value_tp *v, print_info *f)
          mpz_get_str(f->s->s + f->pos, 10, v->v.z->z);
          f->pos += strlen(f->s->s + f->pos);
        return;
+       case REP_wide:
+         mpz_init(z);
+         wide_get_z(z, v->v.wd->w);
+         var_str_ensure(f->s, f->pos + mpz_sizeinbase(z, 10)+1);
+         mpz_get_str(f->s->s + f->pos, 10, z);
+         f->pos += strlen(f->s->s + f->pos);
+         mpz_clear(z);
+       return;
        case REP_symbol:
          print_string(v->v.s, f);
        return;
@@ -592,7 +602,7 @@ static void _named_wire_exec(value_tp *v, type *tp, name_info *f)
    int pos = VAR_STR_LEN(&f->scratch);
    if (tp && tp->kind == TP_generic)
      { fprintf(stderr, "In instance %s of process %s(%s[%d:%d]),\n"
-               "port %s has templated type\n", f->p->nm, f->p->p->id,
+               "port %s has templated type\n", ps_name(f->p), f->p->p->id,
                f->p->p->src, f->p->p->lnr, f->p->p->lpos, f->scratch.s);
        exit(1);
      }
@@ -648,7 +658,8 @@ static void _named_wire_exec(value_tp *v, type *tp, name_info *f)
            }
          else if (v->v.p->p)
            { fprintf(stderr, "In instance %s of process %s(%s[%d:%d]),\n"
-                     "port %s is not a wired port\n", f->p->nm, f->p->p->id,
+                     "port %s is not a wired port\n",
+                     ps_name(f->p), f->p->p->id,
                      f->p->p->src, f->p->p->lnr, f->p->p->lpos, f->scratch.s);
              exit(1);
            }
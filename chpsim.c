@@ -86,6 +86,8 @@ static void exec_all(user_info *U, process_def *dp, llist *trl)
    set_traces(f, trl);
    interact_instantiate(f);
    prepare_chp(f);
+   if (IS_SET(U->flags, USER_lean))
+     { drop_debug_info(f); }
    interact_chp(f);
    report(f->user, "--- done -------------------------------\n");
    term_exec(f);
@@ -106,6 +108,7 @@ static void usage(const char *fmt, ...)
 	"\t-I-            - clear module search path\n"
 	"\t-C command ... - execute a command before interaction\n"
 	"\t-batch         - non-interactive execution\n"
+	"\t-lean          - batch mode, free debug-only data before chp\n"
 	"\t-q             - quit after executing all -C commands\n"
 	"\t-log file      - keep log of interaction\n"
 	"\t-o file        - use this file for print() and stdout\n",
@@ -121,6 +124,9 @@ static void usage(const char *fmt, ...)
 	"\t-timeseed      - use system clock as seed for PRNG\n"
 	"\t-critical      - track critical timing paths\n"
 	"\t-nohide        - name and track value-union processes\n"
+	"\t-memo          - cache results of sequential functions\n"
+	"\t-prune         - do not simulate unobservable or constant prs\n"
+	"\t-levels file   - choose chp/hse/prs/meta bodies per instance\n"
 	"\n"
    );
    if (fmt)
@@ -180,6 +186,11 @@ extern int main(int argc, char *argv[])
 	   if (!U->log)
 	     { U->log = stderr; }
 	 }
+       else if (!strcmp(argv[i], "-lean"))
+         { SET_FLAG(U->flags, USER_batch | USER_lean);
+	   if (!U->log)
+	     { U->log = stderr; }
+	 }
        else if (!strcmp(argv[i], "-q"))
          { SET_FLAG(U->flags, USER_quit); }
        else if (!strcmp(argv[i], "-C"))
@@ -225,7 +236,15 @@ extern int main(int argc, char *argv[])
        else if (!strcmp(argv[i], "-watchall"))
          { SET_FLAG(U->flags, USER_watchall); }
        else if (!strcmp(argv[i], "-nohide"))
-         { SET_FLAG(U->flags, USER_nohide); }
+         { SET_FLAG(U->flags, USER_nohide | USER_keepwu); }
+       else if (!strcmp(argv[i], "-memo"))
+         { SET_FLAG(U->flags, USER_memo); }
+       else if (!strcmp(argv[i], "-prune"))
+         { SET_FLAG(U->flags, USER_prune); }
+       else if (!strcmp(argv[i], "-levels"))
+         { i = need_arg(argc, argv, i);
+           read_levels(U, argv[i]);
+         }
        else if (!strcmp(argv[i], "-critical"))
          { SET_FLAG(U->flags, USER_critical);
            RESET_FLAG(U->flags, USER_random);
@@ -248,6 +267,8 @@ extern int main(int argc, char *argv[])
          { usage("Too many arguments: %s", argv[i]); }
        i++;
      }
+   if (IS_SET(U->flags, USER_lean) && !llist_is_empty(&U->cmds))
+     { usage("-lean cannot be combined with -C"); }
    builtin_io_change_std(U->user_stdout, 1);
    if (U->log)
      { fprintf(U->log, "Command line:");
@@ -37,7 +37,7 @@ extern void hash_table_init
  { uint k;
    hash_entry *e;
    k = HASH_MIN_SIZE;
-   if (size > HASH_MAX_SIZE) size = HASH_MAX_SIZE;
+   if (size > HASH_MAX_SIZE && !IS_SET(flags, HASH_open)) size = HASH_MAX_SIZE;
    while (k < size)
      { k = k << 1; }
    h->size = k;
@@ -175,6 +175,116 @@ static uint hash(hash_table *h, const char *s)
      }
  }
 
+/* Open tables use a different hash function: the key is folded into a
+   ulong (FNV-1a for strings and byte sequences), which is then mixed by
+   a multiplication with the golden ratio, so that all bits of the key
+   (in particular the high bits of aligned pointers) affect the low bits
+   that select the bucket.
+*/
+
+#if ULONG_MAX > 0xffffffffUL
+#define FNV_BASIS 0xcbf29ce484222325UL
+#define FNV_PRIME 0x100000001b3UL
+#define GOLDEN 0x9e3779b97f4a7c15UL
+#define GOLDEN_SHIFT 32
+#else
+#define FNV_BASIS 0x811c9dc5UL
+#define FNV_PRIME 0x01000193UL
+#define GOLDEN 0x9e3779b9UL
+#define GOLDEN_SHIFT 16
+#endif
+
+static uint open_hash(hash_table *h, const char *s)
+ /* Pre: s != 0, HASH_open is set.
+    Returns the bucket at which the search for s starts.
+ */
+ { ulong x;
+   const ubyte *c;
+   uint i;
+   if (IS_SET(h->flags, HASH_ptr_is_key))
+     { x = (ulong)s; }
+   else
+     { x = FNV_BASIS;
+       c = (const ubyte*)s;
+       if (IS_SET(h->flags, HASH_fixed_len_key))
+	 { for (i = 0; i < h->key_len; i++)
+	     { x = (x ^ c[i]) * FNV_PRIME; }
+	 }
+       else
+	 { while (*c)
+	     { x = (x ^ *c) * FNV_PRIME;
+	       c++;
+	     }
+	 }
+     }
+   x = x * GOLDEN;
+   x = x ^ (x >> GOLDEN_SHIFT);
+   return x & (h->size - 1);
+ }
+
+static int key_eq(hash_table *h, const char *k, const char *key)
+ /* true if k and key are the same key of h */
+ { if (IS_SET(h->flags, HASH_ptr_is_key)) return k == key;
+   if (IS_SET(h->flags, HASH_fixed_len_key))
+     { return !memcmp(k, key, h->key_len); }
+   return !strcmp(k, key);
+ }
+
+static hash_entry *open_find(hash_table *h, const char *key)
+ /* Return the entry for key, or the empty entry where it would go */
+ { uint x, m = h->size - 1;
+   hash_entry *e;
+   x = open_hash(h, key);
+   e = &h->table[x];
+   while (e->key && !key_eq(h, e->key, key))
+     { x = (x + 1) & m;
+       e = &h->table[x];
+     }
+   return e;
+ }
+
+static int open_set_size(hash_table *h, uint size)
+ /* Same as hash_set_size(), for an open table */
+ { hash_entry *e, *t, *d;
+   uint k, i, old_size;
+   k = HASH_MIN_SIZE;
+   while (k < size || k/4*3 <= h->nr_entries)
+     { k = k << 1; }
+   t = malloc(k*sizeof(*t)); /* no errors */
+   if (!t) return 0;
+   d = h->table; h->table = t;
+   old_size = h->size; h->size = k;
+   for (e = h->table, i = h->size; i; e++, i--)
+     { e->key = 0; }
+   for (e = d, i = old_size; i; e++, i--)
+     { if (e->key)
+	 { *open_find(h, e->key) = *e; }
+     }
+   free(d);
+   return 1;
+ }
+
+static void open_delete(hash_table *h, hash_entry *e)
+ /* Pre: e is an entry of h, and its key has already been freed.
+    Remove e, moving later entries of its probe sequence back so that
+    all elements can still be found.
+ */
+ { uint i, j, x, m = h->size - 1;
+   i = j = e - h->table;
+   while (1)
+     { j = (j + 1) & m;
+       if (!h->table[j].key) break;
+       x = open_hash(h, h->table[j].key);
+       /* entry j can move to i if x is not cyclically in (i, j] */
+       if (i < j? (x <= i || x > j) : (x <= i && x > j))
+	 { h->table[i] = h->table[j];
+	   i = j;
+	 }
+     }
+   h->table[i].key = 0;
+   h->nr_entries--;
+ }
+
 /********** element operations ***********************************************/
 
 extern hash_entry *hash_find(hash_table *h, const char *key)
@@ -184,6 +294,10 @@ extern hash_entry *hash_find(hash_table *h, const char *key)
  */
  { uint x;
    hash_entry *l;
+   if (IS_SET(h->flags, HASH_open))
+     { l = open_find(h, key);
+       return l->key? l : 0;
+     }
    x = hash(h, key);
    l = &h->table[x];
    if (!l->key) return 0;
@@ -205,23 +319,35 @@ extern int hash_insert(hash_table *h, const char *key, hash_entry **q)
  */
  { uint x;
    hash_entry *l, *e;
-   x = hash(h, key);
-   e = l = &h->table[x];
-   if (l->key)
-     { if (IS_SET(h->flags, HASH_ptr_is_key))
-	 while (l && l->key != key) { l = l->tail; }
-       else if (IS_SET(h->flags, HASH_fixed_len_key))
-         while (l && memcmp(l->key, key, h->key_len)) { l = l->tail; }
-       else
-         while (l && strcmp(l->key, key)) { l = l->tail; }
-       if (l)
+   if (IS_SET(h->flags, HASH_open))
+     { l = open_find(h, key);
+       if (l->key)
 	 { if (q) *q = l; return 1; }
-       NEW(l);
-       l->tail = e->tail;
-       e->tail = l;
+       if (h->size/4*3 <= h->nr_entries + 1) /* keep empty entries */
+	 { open_set_size(h, 2*h->size);
+	   l = open_find(h, key);
+	 }
+       l->tail = 0;
      }
    else
-     { l->tail = 0; }
+     { x = hash(h, key);
+       e = l = &h->table[x];
+       if (l->key)
+	 { if (IS_SET(h->flags, HASH_ptr_is_key))
+	     while (l && l->key != key) { l = l->tail; }
+	   else if (IS_SET(h->flags, HASH_fixed_len_key))
+	     while (l && memcmp(l->key, key, h->key_len)) { l = l->tail; }
+	   else
+	     while (l && strcmp(l->key, key)) { l = l->tail; }
+	   if (l)
+	     { if (q) *q = l; return 1; }
+	   NEW(l);
+	   l->tail = e->tail;
+	   e->tail = l;
+	 }
+       else
+	 { l->tail = 0; }
+     }
    h->nr_entries++;
    if (IS_SET(h->flags, HASH_no_alloc_keys|HASH_ptr_is_key))
      { l->key = (char*)key; }
@@ -233,7 +359,7 @@ extern int hash_insert(hash_table *h, const char *key, hash_entry **q)
      { NEW_ARRAY(l->key, strlen(key)+1);
        strcpy(l->key, key);
      }
-   if (!IS_SET(h->flags, HASH_no_auto_size) && h->size < HASH_MAX_SIZE
+   if (!IS_SET(h->flags, HASH_no_auto_size|HASH_open) && h->size < HASH_MAX_SIZE
        && h->nr_entries >= 4*h->size)
      { hash_set_size(h, 4*h->size);
        if (q) *q = hash_find(h, key);
@@ -249,6 +375,19 @@ extern int hash_delete(hash_table *h, const char *key)
  */
  { uint x;
    hash_entry *l, *prev, *tmp;
+   if (IS_SET(h->flags, HASH_open))
+     { l = open_find(h, key);
+       if (!l->key) return 0;
+       if (h->del_data)
+	 { h->del_data(l, h->del_info); }
+       if (!IS_SET(h->flags, HASH_no_free_keys|HASH_ptr_is_key))
+	 { free(l->key); }
+       open_delete(h, l);
+       if (!IS_SET(h->flags, HASH_no_auto_size) && h->size > HASH_MIN_SIZE
+	   && h->nr_entries <= h->size/8)
+	 { open_set_size(h, h->size/2); }
+       return 1;
+     }
    x = hash(h, key);
    l = &h->table[x];
    prev = 0;
@@ -356,6 +495,21 @@ extern int hash_apply_delete(hash_table *h, hash_func *f, void *x)
  */
  { uint j, n = 0;
    hash_entry *e, *prev, *tmp;
+   if (IS_SET(h->flags, HASH_open))
+     { for (j = 0; j < h->size; j++)
+	 { e = &h->table[j];
+	   if (!e->key || !f(e, x)) continue;
+	   n++;
+	   if (!IS_SET(h->flags, HASH_no_free_keys|HASH_ptr_is_key))
+	     { free(e->key); }
+	   e->key = 0;
+	 }
+       /* the probe sequences are broken now, so rebuild the table */
+       h->nr_entries -= n;
+       if (n) open_set_size(h, IS_SET(h->flags, HASH_no_auto_size)?
+				h->size : HASH_MIN_SIZE);
+       return n;
+     }
    for (j = 0; j < h->size; j++)
      { e = &h->table[j];
        prev = 0;
@@ -428,6 +582,8 @@ extern int hash_set_size(hash_table *h, uint size)
  */
  { hash_entry *e, *t, *d, *tmp;
    uint k, i, old_size;
+   if (IS_SET(h->flags, HASH_open))
+     { return open_set_size(h, size); }
    k = HASH_MIN_SIZE;
    if (size > HASH_MAX_SIZE) size = HASH_MAX_SIZE;
    while (k < size)
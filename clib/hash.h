@@ -44,11 +44,20 @@ along with this file.  If not, see <http://www.gnu.org/licenses/>.
    size is not critical for performance, and you don't need to worry about
    it. (If size is >> nr_elements, you're wasting space;
    if size <<< nr_elements, operations may slow down.)
+
+   By default, entries that hash to the same bucket are chained, and the
+   table has at most HASH_MAX_SIZE buckets. With HASH_open, the table uses
+   open addressing (linear probing) instead, which avoids an allocation
+   per entry and has no size limit; this is meant for large tables with
+   pointer or fixed-length keys, but works with strings as well. In an
+   open table, the tail field is unused, and entries move whenever an
+   element is inserted or deleted, so a hash_entry* is only valid until
+   the next modification of the table.
 */
 
 /* both must be powers of 2 */
 #define HASH_MIN_SIZE 4U /* >= 1U */
-#define HASH_MAX_SIZE 32768U /* <= 65536U */
+#define HASH_MAX_SIZE 32768U /* <= 65536U; chained tables only */
 
 /********** data structure ***************************************************/
 
@@ -75,6 +84,8 @@ typedef enum hash_flags
 	/* the pointer itself is the (fixed-size) key (implies const_keys) */
    , HASH_fixed_len_key = HASH_ptr_is_key << 1
 	/* the key is a fixed-size byte sequence */
+   , HASH_open = HASH_fixed_len_key << 1
+	/* use open addressing rather than chaining (see above) */
    } hash_flags;
 
 typedef int hash_func(hash_entry *, void *);
@@ -100,7 +111,7 @@ extern void hash_table_init
  (hash_table *h, uint size, hash_flags flags, hash_func *del_data);
  /* Pre: h has been allocated, but not initialized.
     Initializes h to the smallest power of 2 >= size (subject to HASH_MIN_SIZE
-    and HASH_MAX_SIZE), with the given flags.
+    and, unless HASH_open is set, HASH_MAX_SIZE), with the given flags.
     If del_data != 0, del_data(entry, del_info) is called whenever an
     element is deleted. (del_info is set to 0 by default.)
     If HASH_fixed_len_key is set, you must set h->key_len immediately
@@ -175,7 +186,8 @@ extern int hash_apply_delete(hash_table *h, hash_func *f, void *x);
 extern int hash_set_size(hash_table *h, uint size);
  /* Pre: h has been initialized.
     Change size of h to size (rounded up to power of 2, subject to
-    HASH_MIN_SIZE and HASH_MAX_SIZE).
+    HASH_MIN_SIZE and, unless HASH_open is set, HASH_MAX_SIZE; an open
+    table is never made too small for its elements).
     Return is 1, except if size could not be adjusted because there
     was not enough memory.
  */
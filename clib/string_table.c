@@ -38,11 +38,20 @@ extern str *make_str(const char *s)
    return q->key;
  }
 
+extern str *find_str(const char *s)
+ /* If s was made into a str before, return that str; otherwise return 0.
+    (Unlike make_str, this does not add s to the table.)
+ */
+ { hash_entry *q;
+   q = hash_find(&str_table, s);
+   return q? q->key : 0;
+ }
+
 extern void init_string_table(void)
  /* Call this before anything else in this file. (Multiple calls ok.) */
  { static int done = 0;
    if (!done)
-     { hash_table_init(&str_table, 100, HASH_no_free_keys, 0); }
+     { hash_table_init(&str_table, 100, HASH_no_free_keys | HASH_open, 0); }
    LEAK(str_table.table);
    done = 1;
  }
@@ -49,5 +49,10 @@ extern str *make_str(const char *s);
     The memory pointed to by s can be reused.
  */
 
+extern str *find_str(const char *s);
+ /* If s was made into a str before, return that str; otherwise return 0.
+    (Unlike make_str, this does not add s to the table.)
+ */
+
 
 #endif /* STRING_TABLE_H */
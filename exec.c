@@ -58,6 +58,7 @@
 #include "routines.h"
 #include "expr.h"
 #include "properties.h"
+#include "statement.h"
 
 /*extern*/ int app_exec = -1;
 /*extern*/ int app_pop = -1;
@@ -75,20 +76,25 @@ static void exec_info_init(exec_info *f, user_info *U)
      { pqueue_init(&f->sched, 0, (pqueue_func*)action_cmp);
        mpz_init_set_ui(f->time, 1);
      }
-   hash_table_init(&f->delays, 1, HASH_ptr_is_key, 0);
-   llist_init(&f->check);
+   hash_table_init(&f->delays, 1, HASH_ptr_is_key | HASH_open, 0);
+   f->check = 0;
+   f->nr_check = f->max_check = 0;
    llist_init(&f->chp);
    llist_init(&f->susp_perm);
    f->nr_susp = 0;
    f->curr = 0;
    f->meta_ps = 0;
-   f->stack = 0; f->fl = 0;
+   f->stack = 0; f->nr_stack = f->max_stack = 0;
+   f->fl = 0;
    f->val = 0;
+   f->pkv.rep = REP_none;
+   f->pk = 0;
    f->err_obj = 0;
    var_str_init(&f->scratch, 0);
    var_str_init(&f->err, 0);
    f->crit = 0;
    f->ecount = 0;
+   f->nr_impure = 0;
    f->user = U;
  }
 
@@ -99,8 +105,11 @@ extern void exec_info_init_main(exec_info *f, user_info *U)
    U->global = f;
    if (IS_SET(U->flags, USER_critical))
      { NEW(f->crit_map);
-       hash_table_init(f->crit_map, 1, HASH_ptr_is_key, 0);
+       hash_table_init(f->crit_map, 1, HASH_ptr_is_key | HASH_open, 0);
      }
+   NEW(f->compat);
+   hash_table_init(f->compat, 1, HASH_fixed_len_key, 0);
+   f->compat->key_len = sizeof(type_pair);
    NEW(f->prop);
    init_property_info(f->prop);
  }
@@ -110,12 +119,14 @@ extern void exec_info_init_sub(exec_info *f, exec_info *g)
  { exec_info_init(f, g->user);
    f->parent = g;
    f->crit_map = g->crit_map;
+   f->compat = g->compat;
  }
 
 extern void exec_info_init_eval(exec_info *f, process_state *ps)
  /* Initialize *f for evaluation only */
  { f->flags = EXEC_eval_only;
-   f->stack = 0; f->fl = 0;
+   f->stack = 0; f->nr_stack = f->max_stack = 0;
+   f->fl = 0;
    f->curr = 0;
    f->meta_ps = ps;
    var_str_init(&f->scratch, 0);
@@ -131,9 +142,11 @@ extern void exec_info_term(exec_info *f)
        hash_table_free(&f->delays);
        if (!IS_SET(f->user->flags, USER_random))
          { mpz_clear(f->time); }
+       if (f->check) free(f->check);
      }
    f->curr = 0;
-   assert(!f->stack);
+   assert(!f->nr_stack);
+   if (f->stack) free(f->stack);
    w = f->fl;
    while (w)
      { tmp = w; w = w->next;
@@ -204,29 +217,76 @@ extern action *new_action(exec_info *f)
    return a;
  }
 
-static int collect_ps_child(process_state *x, process_state *ps)
-/* If ps is a parent of x, add x as a child and return 1.
- * Otherwise return 0.
+typedef struct adopt_info adopt_info;
+struct adopt_info
+   { user_info *f;
+     process_state *ps;
+   };
+
+static int adopt_ps_child(process_state *x, adopt_info *g)
+/* If x is a descendant of g->ps (x and g->ps have the same parent),
+ * make x a child of g->ps and return 1. Otherwise return 0.
  */
  { int len;
-   len = strlen(ps->nm);
-   if (strncmp(ps->nm, x->nm, len) || x->nm[len] != '/') return 0;
-   llist_prepend(&ps->children, x);
+   hash_entry *e;
+   len = strlen(g->ps->in.id);
+   if (strncmp(g->ps->in.id, x->in.id, len) || x->in.id[len] != '/')
+     { return 0; }
+   hash_delete(&g->f->instances, (char*)&x->in);
+   x->in.parent = g->ps;
+   x->in.id = make_str(x->in.id + len + 1);
+   hash_insert(&g->f->instances, (char*)&x->in, &e);
+   e->data.p = x;
+   llist_prepend(&g->ps->children, x);
    return 1;
  }
 
-static int add_ps_child(process_state *prnt, process_state *ps)
-/* If prnt is a parent of ps, add ps as a child and return 1.
- * Otherwise return 0.
+static void add_instance
+(user_info *f, process_state *ps, process_state *prnt, const str *id)
+/* Make ps the instance named id in prnt, where prnt is the closest
+ * existing ancestor of ps. If ancestors are missing, id contains '/'
+ * and f->ps_skip is set: from then on, a new instance may have to
+ * adopt some of the children of its parent.
  */
- { int len;
-   len = strlen(prnt->nm);
-   if (len == 1) len = 0;
-   if (strncmp(prnt->nm, ps->nm, len) || ps->nm[len] != '/') return 0;
-   llist_all_extract(&prnt->children, (llist_func*)collect_ps_child, ps);
-   if (!llist_apply(&prnt->children, (llist_func*)add_ps_child, ps))
-     { llist_prepend(&prnt->children, ps); }
-   return 1;
+ { hash_entry *e;
+   adopt_info g;
+   ps->in.parent = prnt;
+   ps->in.id = id;
+   hash_insert(&f->instances, (char*)&ps->in, &e);
+   e->data.p = ps;
+   if (strchr(id, '/'))
+     { f->ps_skip = 1; }
+   else if (f->ps_skip)
+     { g.f = f;
+       g.ps = ps;
+       llist_all_extract(&prnt->children, (llist_func*)adopt_ps_child, &g);
+     }
+   llist_prepend(&prnt->children, ps);
+ }
+
+static process_state *alloc_process_state(exec_info *f, const str *nm)
+ { process_state *ps;
+   NEW(ps);
+   ps->refcnt = 1;
+   ps->p = 0;
+   ps->nm = nm;
+   ps->in.parent = 0;
+   ps->in.id = 0;
+   ps->meta = 0;
+   ps->nr_meta = 0;
+   ps->cs = new_ctrl_state(f);
+   ps->cs->ps = ps;
+   ps->cs->cxt = 0; /* f->curr->cxt is never right */
+   ps->nr_thread = 0;
+   ps->nr_susp = 0;
+   ps->children = 0;
+   llist_init(&ps->ready);
+   if (IS_SET(f->user->flags, USER_traceall))
+     { ps->flags = DBG_trace; }
+   else
+     { ps->flags = 0; }
+   strict_check_init(ps, f); /* TODO: Only when EXPR_ifrchk is set */
+   return ps;
  }
 
 extern process_state *new_process_state(exec_info *f, const str *nm)
@@ -235,36 +295,35 @@ extern process_state *new_process_state(exec_info *f, const str *nm)
     If a process_state with the specified name already exists and the process is
     not invisible, that state is returned instead.
  */
- { process_state *ps;
+ { process_state *ps, *prnt;
+   const char *rest;
    ps = find_instance(f->user, nm, 0);
    if (!ps)
-     { NEW(ps);
-       ps->refcnt = 1;
-       ps->p = 0;
-       ps->nm = (str*)nm;
-       ps->meta = 0;
-       ps->nr_meta = 0;
-       ps->cs = new_ctrl_state(f);
-       ps->cs->ps = ps;
-       ps->cs->cxt = 0; /* f->curr->cxt is never right */
-       ps->nr_thread = 0;
-       ps->nr_susp = 0;
-       ps->children = 0;
-       if (IS_SET(f->user->flags, USER_traceall))
-         { ps->flags = DBG_trace; }
-       else
-         { ps->flags = 0; }
-       strict_check_init(ps, f); /* TODO: Only when EXPR_ifrchk is set */
+     { ps = alloc_process_state(f, nm);
        if (!is_visible(ps))
          { llist_prepend(&f->user->hprocs, ps); }
-       else if (f->user->main)
-         { add_ps_child(f->user->main, ps); }
-       else if (strcmp(nm, "/"))
-         { new_process_state(f, "/");
-           add_ps_child(f->user->main, ps);
-         }
-       else
+       else if (!strcmp(nm, "/"))
          { f->user->main = ps; }
+       else if (nm[0] == '/') /* otherwise not part of the hierarchy */
+         { if (!f->user->main) new_process_state(f, make_str("/"));
+           prnt = find_ancestor(f->user, nm, &rest);
+           add_instance(f->user, ps, prnt, make_str(rest));
+         }
+     }
+   else if (ps->nr_thread != 0)
+     { assert(!"Duplicated instance name"); }
+   ps->refcnt++;
+   return ps;
+ }
+
+extern process_state *new_child_process_state
+(exec_info *f, process_state *prnt, const str *id)
+ /* Same as new_process_state(), for the instance named id in prnt */
+ { process_state *ps;
+   ps = find_child(f->user, prnt, id);
+   if (!ps)
+     { ps = alloc_process_state(f, 0);
+       add_instance(f->user, ps, prnt, id);
      }
    else if (ps->nr_thread != 0)
      { assert(!"Duplicated instance name"); }
@@ -279,7 +338,8 @@ extern void free_process_state(process_state *ps, exec_info *f)
  { value_tp *v;
    int i;
    if (!ps->refcnt)
-     { v = ps->var;
+     { free_ready_sets(ps, f);
+       v = ps->var;
        for (i = 0; i < ps->nr_var; i++)
          { clear_value_tp(&v[i], f); }
        if (v)
@@ -317,7 +377,7 @@ extern void exec_error(exec_info *f, void *obj, const char *fmt, ...)
    va_list a, b;
    va_start(a, fmt);
    pos = var_str_printf(&f->err, 0, "Error: %s at %s[%d:%d]\n\t",
-                f->curr? f->curr->ps->nm : "", x->src, x->lnr, x->lpos);
+                f->curr? ps_name(f->curr->ps) : "", x->src, x->lnr, x->lpos);
    pos += var_str_vprintf(&f->err, pos, fmt, a);
    if (f->err.s[pos-1] != '\n')
      { f->err.s[pos++] = '\n';
@@ -327,7 +387,7 @@ extern void exec_error(exec_info *f, void *obj, const char *fmt, ...)
    report(f->user, "--- error ------------------------------\n");
    report(f->user, "%s", f->err.s);
    if (IS_SET(f->user->flags, USER_debug))
-     { while (f->stack)
+     { while (f->nr_stack)
          { pop_value(&v, f);
            clear_value_tp(&v, f);
          }
@@ -351,7 +411,7 @@ extern void exec_warning(exec_info *f, void *obj, const char *fmt, ...)
    if (IS_SET(f->user->flags, USER_debug)) return;
    va_start(a, fmt);
    pos = var_str_printf(&f->err, 0, "Warning: %s at %s[%d:%d]\n\t%v\n\t",
-                        f->curr->ps->nm, x->src, x->lnr, x->lpos,
+                        ps_name(f->curr->ps), x->src, x->lnr, x->lpos,
                         vstr_stmt, f->curr->obj);
    pos += var_str_vprintf(&f->err, pos, fmt, a);
    if (f->err.s[pos-1] != '\n')
@@ -378,7 +438,7 @@ static void prs_error(exec_info *f, action *a, wire_value *w, const char *err)
      { f->meta_ps = a->cs->ps;
        print_wire_exec(a->target.w, f);
        pos += var_str_printf(&f->err, pos, "  caused %s on wire %s of process"
-                             " %s\n", err, f->scratch.s, f->meta_ps->nm);
+                             " %s\n", err, f->scratch.s, ps_name(f->meta_ps));
        f->meta_ps = meta_ps;
      }
    report(f->user, "--- error ------------------------------\n");
@@ -457,8 +517,8 @@ extern void run_checks(wire_value *w, exec_info *f)
   */
  { hash_entry *q;
    action *a, *b;
-   while (!llist_is_empty(&f->check))
-     { a = llist_idx_extract(&f->check, 0);
+   while (f->nr_check)
+     { a = f->check[--f->nr_check];
        RESET_FLAG(a->flags, ACTION_check);
        if (IS_SET(a->flags, ACTION_is_cr))
          { if ((a->flags & (ACTION_pr_up | ACTION_up_nxt)) == ACTION_up_nxt)
@@ -505,6 +565,17 @@ extern void sched_instance(ctrl_state *cs, exec_info *f)
    cs->cxt = p->cxt;
  }
 
+static void *level_body(process_def *p, body_level lvl)
+ /* Return the body of p for lvl, or 0 if there is none */
+ { switch (lvl)
+     { case LEVEL_meta: return p->mb;
+       case LEVEL_chp: return p->cb;
+       case LEVEL_hse: return p->hb;
+       case LEVEL_prs: return p->pb;
+       default: return 0;
+     }
+ }
+
 extern void sched_instance_real(ctrl_state *cs, exec_info *f)
 /* Only use this during instantiation when nothing is scheduled */
  { process_def *p = cs->ps->p;
@@ -512,12 +583,14 @@ extern void sched_instance_real(ctrl_state *cs, exec_info *f)
    exec_info *g;
    assert(cs->ps->nr_thread == -1);
    cs->ps->nr_thread = 1;
-   if (p->mb && !IS_SET(f->flags, EXEC_sequential))
-     { b = p->mb; }
-   else if (p->pb) b = p->pb;
-   else if (p->hb) b = p->hb;
-   else if (p->cb) b = p->cb;
-   else b = p->mb;
+   b = level_body(p, instance_level(f->user, cs->ps));
+   if (!b)
+     { if (p->mb && !IS_SET(f->flags, EXEC_sequential)) b = p->mb;
+       else if (p->pb) b = p->pb;
+       else if (p->hb) b = p->hb;
+       else if (p->cb) b = p->cb;
+       else b = p->mb;
+     }
    cs->ps->b = b;
    cs->cxt = cs->ps->b->cxt;
    if (b == p->mb)
@@ -587,9 +660,11 @@ static int _clear_action_dep(wire_expr *e, exec_info *f)
  }
 
 static int clear_action_dep(wire_value *w, exec_info *f)
- { llist_all_extract(&w->u.dep, (llist_func*)_clear_action_dep, f);
-   if (llist_is_empty(&w->u.dep))
-     { RESET_FLAG(w->flags, WIRE_has_dep); }
+ { dep_list_extract(&w->u.dep, (dep_func*)_clear_action_dep, f);
+   if (!w->u.dep.nr)
+     { dep_list_free(&w->u.dep);
+       RESET_FLAG(w->flags, WIRE_has_dep);
+     }
    return 0;
  }
 
@@ -652,7 +727,10 @@ extern void exec_run(exec_info *f)
          }
        else if (IS_SET(a->flags, ACTION_delay_susp))
          { RESET_FLAG(a->flags, ACTION_delay_susp);
-           next_stmt(f);
+           if (IS_SET(ps->flags, PROC_native))
+             { insert_sched(f->curr, f); } /* resume the native code */
+           else
+             { next_stmt(f); }
          }
        else
          { x = f->curr->obj;
@@ -661,11 +739,12 @@ extern void exec_run(exec_info *f)
              { interact_report(f); }
            else if (IS_SET(ps->flags, DBG_trace))
              { report(f->user, "(trace) %s at %s[%d:%d]\n\t%v\n",
-                      f->curr->ps->nm, x->src, x->lnr, x->lpos, vstr_stmt, x);
+                      ps_name(f->curr->ps), x->src, x->lnr, x->lpos,
+                      vstr_stmt, x);
              }
            RESET_FLAG(f->flags, EXEC_warning | EXEC_immediate);
            r = exec_obj(x, f);
-           assert(!f->stack);
+           assert(!f->nr_stack);
            if (IS_SET(f->flags, EXEC_warning))
              { RESET_FLAG(f->flags, EXEC_warning);
                interact(f, "continue");
@@ -677,7 +756,8 @@ extern void exec_run(exec_info *f)
            else if (r == EXEC_next)
              { next_stmt(f); }
            else if (r == EXEC_suspend)
-             { if (llist_is_empty(&f->curr->dep))
+             { if (llist_is_empty(&f->curr->dep) &&
+                   !IS_SET(a->flags, ACTION_ready))
                  { llist_prepend(&f->susp_perm, f->curr); }
                SET_FLAG(a->flags, ACTION_susp);
                f->nr_susp++;
@@ -742,23 +822,346 @@ static int run_properties(ctrl_state *s, exec_info *f)
    return 0;
  }
 
+/********** pruning **********************************************************/
+
+/* With -prune, production rules that cannot affect anything observable
+   are removed from the fanout lists of their inputs once all processes
+   have been instantiated.  A wire is observable if a chp or hse process
+   (or a builtin process) has access to it, if it is watched, if it is
+   read by anything other than a production rule (e.g., a property or a
+   delay hold), or if it is an input of a production rule of an observable
+   wire.  A wire is constant if it is connected to a rail, or if all its
+   production rules have constant guards that keep it at its initial
+   value.  Constant wires propagate through the guards that read them.
+   Wires that are unobservable or constant get WIRE_pruned; the rules
+   that only lead to pruned wires are never evaluated again, so they can
+   no longer cause interference or instability errors either.
+*/
+
+FLAGS(prune_flags)
+   { FIRST_FLAG(PRUNE_observed), /* wire is observable */
+     NEXT_FLAG(PRUNE_const), /* wire never changes */
+     NEXT_FLAG(PRUNE_has_up), /* pu is the pull-up guard */
+     NEXT_FLAG(PRUNE_has_dn), /* pd is the pull-down guard */
+     NEXT_FLAG(PRUNE_scanned) /* fanouts of the wire have been scanned */
+   };
+
+typedef struct prune_wire prune_wire;
+struct prune_wire
+   { wire_value *w;
+     prune_flags flags;
+     wire_expr *pu, *pd; /* top of the guards of the production rules */
+     llist fanin; /* llist(wire_value) inputs of the production rules */
+   };
+
+typedef struct prune_info prune_info;
+struct prune_info
+   { hash_table wires; /* wire_value -> prune_wire */
+     hash_table exprs; /* wire_expr -> nr of constant inputs, -1 if frozen */
+     llist todo; /* llist(prune_wire) */
+     long nr_wire, nr_unobs, nr_const, nr_pr, nr_dep;
+   };
+
+/* hash_func */
+static int prune_wire_delete(hash_entry *q, void *dummy)
+ { prune_wire *pw = q->data.p;
+   llist_free(&pw->fanin, 0, 0);
+   free(pw);
+   return 0;
+ }
+
+static prune_wire *get_prune_wire(wire_value *w, prune_info *g)
+ /* Return the entry for w, creating it if necessary */
+ { hash_entry *q;
+   prune_wire *pw;
+   if (hash_insert(&g->wires, (char*)w, &q)) return q->data.p;
+   NEW(pw);
+   pw->w = w;
+   pw->flags = 0;
+   pw->pu = pw->pd = 0;
+   llist_init(&pw->fanin);
+   q->data.p = pw;
+   return pw;
+ }
+
+static int is_pr_expr(wire_expr *e)
+ /* Pre: e is an action.  true if e is the guard of a production rule */
+ { return ((e->flags & WIRE_action) == WIRE_pu ||
+           (e->flags & WIRE_action) == WIRE_pd) &&
+          !IS_SET(e->u.act->flags, ACTION_is_cr);
+ }
+
+static void prune_scan_dep(wire_expr *e, prune_wire *in, prune_info *g)
+ /* e depends on in->w, follow e to the actions it triggers */
+ { prune_wire *pw;
+   llist m;
+   while (!IS_SET(e->flags, WIRE_action | WIRE_llist))
+     { e = e->u.dep; }
+   if (IS_SET(e->flags, WIRE_llist))
+     { m = e->u.ldep;
+       while (!llist_is_empty(&m))
+         { prune_scan_dep(llist_head(&m), in, g);
+           m = llist_alias_tail(&m);
+         }
+     }
+   else if (is_pr_expr(e))
+     { pw = get_prune_wire(e->u.act->target.w, g);
+       if (IS_SET(e->flags, WIRE_pu))
+         { pw->pu = e; SET_FLAG(pw->flags, PRUNE_has_up); }
+       else
+         { pw->pd = e; SET_FLAG(pw->flags, PRUNE_has_dn); }
+       llist_prepend(&pw->fanin, in->w);
+     }
+   else
+     { SET_FLAG(in->flags, PRUNE_observed); }
+ }
+
+static void prune_scan(value_tp *v, int obs, prune_info *g)
+ /* Find all wires in v, with their fanouts.  If obs, v is observable. */
+ { long i;
+   prune_wire *pw;
+   dep_list *d;
+   switch (v->rep)
+     { case REP_array: case REP_record:
+         for (i = 0; i < v->v.l->size; i++)
+           { prune_scan(&v->v.l->vl[i], obs, g); }
+       return;
+       case REP_union:
+         prune_scan(&v->v.u->v, obs, g);
+       return;
+       case REP_wwire: case REP_rwire:
+         pw = get_prune_wire(v->v.w, g);
+         if (obs || IS_SET(v->v.w->flags, WIRE_watch))
+           { SET_FLAG(pw->flags, PRUNE_observed); }
+         if (IS_SET(pw->flags, PRUNE_scanned)) return;
+         SET_FLAG(pw->flags, PRUNE_scanned);
+         if (!IS_SET(v->v.w->flags, WIRE_has_dep)) return;
+         d = &v->v.w->u.dep;
+         for (i = d->nr - 1; i >= 0; i--)
+           { prune_scan_dep(DEP_IDX(d, i), pw, g); }
+       return;
+       default:
+       return;
+     }
+ }
+
+static int prune_frozen(wire_expr *e, prune_info *g)
+ /* true if the value of e can no longer change */
+ { hash_entry *q;
+   q = hash_find(&g->exprs, (char*)e);
+   return q && q->data.i < 0;
+ }
+
+static int prune_is_const(prune_wire *pw, prune_info *g)
+ /* true if the production rules of pw->w can never change it */
+ { wire_value *w = pw->w;
+   action *a = w->wframe;
+   int val;
+   if (IS_SET(w->flags, WIRE_undef)) return 0;
+   if (!IS_SET(a->flags, ACTION_is_pr))
+     { return !IS_SET(a->flags, ACTION_dummy) &&
+              !IS_SET(w->flags, WIRE_is_probe) && a->cs->ps == &const_frame_ps;
+     }
+   if (IS_SET(a->flags, ACTION_has_up_pr))
+     { if (IS_SET(pw->flags, PRUNE_has_up))
+         { if (!prune_frozen(pw->pu, g)) return 0;
+           val = IS_SET(pw->pu->flags, WIRE_value);
+         }
+       else
+         { val = IS_SET(a->flags, ACTION_pr_up); }
+       if (val && !IS_SET(w->flags, WIRE_value)) return 0;
+     }
+   if (IS_SET(a->flags, ACTION_has_dn_pr))
+     { if (IS_SET(pw->flags, PRUNE_has_dn))
+         { if (!prune_frozen(pw->pd, g)) return 0;
+           val = IS_SET(pw->pd->flags, WIRE_value);
+         }
+       else
+         { val = IS_SET(a->flags, ACTION_pr_dn); }
+       if (val && IS_SET(w->flags, WIRE_value)) return 0;
+     }
+   return 1;
+ }
+
+static void prune_set_const(prune_wire *pw, prune_info *g)
+ { if (IS_SET(pw->flags, PRUNE_const) || !prune_is_const(pw, g)) return;
+   SET_FLAG(pw->flags, PRUNE_const);
+   llist_prepend(&g->todo, pw);
+ }
+
+/* hash_func */
+static int prune_init_const(hash_entry *q, prune_info *g)
+ { prune_set_const(q->data.p, g);
+   return 0;
+ }
+
+static void prune_freeze(wire_expr *e, wire_flags val, prune_info *g)
+ /* An input of e with value val will no longer change */
+ { hash_entry *q;
+   llist m;
+   if (IS_SET(e->flags, WIRE_trigger) || e->undefcnt) return;
+   if (!hash_insert(&g->exprs, (char*)e, &q))
+     { q->data.i = 0; }
+   if (q->data.i < 0) return;
+   q->data.i++;
+   if (q->data.i < e->refcnt && (IS_SET(e->flags, WIRE_xor) ||
+                                 !((val ^ (e->flags >> WIRE_vd_shft)) & WIRE_value)))
+     { return; }
+   q->data.i = -1; /* e is frozen */
+   if (IS_SET(e->flags, WIRE_action))
+     { if (is_pr_expr(e))
+         { prune_set_const(get_prune_wire(e->u.act->target.w, g), g); }
+     }
+   else if (IS_SET(e->flags, WIRE_llist))
+     { m = e->u.ldep;
+       while (!llist_is_empty(&m))
+         { prune_freeze(llist_head(&m), e->flags, g);
+           m = llist_alias_tail(&m);
+         }
+     }
+   else
+     { prune_freeze(e->u.dep, e->flags, g); }
+ }
+
+/* hash_func */
+static int prune_init_obs(hash_entry *q, prune_info *g)
+ { prune_wire *pw = q->data.p;
+   if (IS_SET(pw->flags, PRUNE_observed))
+     { llist_prepend(&g->todo, pw); }
+   return 0;
+ }
+
+static int prune_dead(wire_expr *e, prune_info *g)
+ /* true if e only leads to production rules of pruned wires */
+ { llist m;
+   while (!IS_SET(e->flags, WIRE_action | WIRE_llist))
+     { e = e->u.dep; }
+   if (IS_SET(e->flags, WIRE_llist))
+     { m = e->u.ldep;
+       while (!llist_is_empty(&m))
+         { if (!prune_dead(llist_head(&m), g)) return 0;
+           m = llist_alias_tail(&m);
+         }
+       return 1;
+     }
+   return is_pr_expr(e) && IS_SET(e->u.act->target.w->flags, WIRE_pruned);
+ }
+
+/* hash_func */
+static int prune_mark(hash_entry *q, prune_info *g)
+ { prune_wire *pw = q->data.p;
+   action *a = pw->w->wframe;
+   g->nr_wire++;
+   if (IS_SET(pw->flags, PRUNE_const))
+     { g->nr_const++; }
+   else if (!IS_SET(pw->flags, PRUNE_observed))
+     { g->nr_unobs++; }
+   else return 0;
+   SET_FLAG(pw->w->flags, WIRE_pruned);
+   if (IS_SET(a->flags, ACTION_has_up_pr)) g->nr_pr++;
+   if (IS_SET(a->flags, ACTION_has_dn_pr)) g->nr_pr++;
+   return 0;
+ }
+
+/* hash_func */
+static int prune_deps(hash_entry *q, prune_info *g)
+ { wire_value *w = ((prune_wire*)q->data.p)->w;
+   if (IS_SET(w->flags, WIRE_has_dep))
+     { g->nr_dep += dep_list_extract(&w->u.dep, (dep_func*)prune_dead, g); }
+   return 0;
+ }
+
+static void prune_wires(llist *l, exec_info *f)
+ /* llist(process_state) l contains all processes that have been started */
+ { prune_info g;
+   process_state *ps;
+   prune_wire *pw, *in;
+   llist m;
+   long i;
+   int obs;
+   hash_table_init(&g.wires, 1, HASH_ptr_is_key | HASH_open,
+                   (hash_func*)prune_wire_delete);
+   hash_table_init(&g.exprs, 1, HASH_ptr_is_key | HASH_open, 0);
+   llist_init(&g.todo);
+   g.nr_wire = g.nr_unobs = g.nr_const = g.nr_pr = g.nr_dep = 0;
+   m = *l;
+   while (!llist_is_empty(&m))
+     { ps = llist_head(&m);
+       m = llist_alias_tail(&m);
+       obs = IS_SET(f->user->flags, USER_watchall) ||
+             ps->b->class != CLASS_prs_body;
+       for (i = 0; i < ps->nr_var; i++)
+         { prune_scan(&ps->var[i], obs, &g); }
+     }
+   /* Constant propagation */
+   hash_apply(&g.wires, (hash_func*)prune_init_const, &g);
+   while (!llist_is_empty(&g.todo))
+     { pw = llist_idx_extract(&g.todo, 0);
+       if (!IS_SET(pw->w->flags, WIRE_has_dep)) continue;
+       for (i = pw->w->u.dep.nr - 1; i >= 0; i--)
+         { prune_freeze(DEP_IDX(&pw->w->u.dep, i), pw->w->flags, &g); }
+     }
+   /* Observability, backwards from the observable wires */
+   hash_apply(&g.wires, (hash_func*)prune_init_obs, &g);
+   while (!llist_is_empty(&g.todo))
+     { pw = llist_idx_extract(&g.todo, 0);
+       if (IS_SET(pw->flags, PRUNE_const)) continue;
+       m = pw->fanin;
+       while (!llist_is_empty(&m))
+         { in = get_prune_wire(llist_head(&m), &g);
+           m = llist_alias_tail(&m);
+           if (IS_SET(in->flags, PRUNE_observed)) continue;
+           SET_FLAG(in->flags, PRUNE_observed);
+           llist_prepend(&g.todo, in);
+         }
+     }
+   hash_apply(&g.wires, (hash_func*)prune_mark, &g);
+   hash_apply(&g.wires, (hash_func*)prune_deps, &g);
+   report(f->user, "(prune) %ld of %ld wires pruned (%ld unobservable, "
+          "%ld constant), %ld production rules and %ld fanouts removed\n",
+          g.nr_unobs + g.nr_const, g.nr_wire, g.nr_unobs, g.nr_const,
+          g.nr_pr, g.nr_dep);
+   hash_table_free(&g.exprs);
+   hash_table_free(&g.wires);
+ }
+
 extern void prepare_chp(exec_info *f)
  /* Prepare chp execution phase */
  { ctrl_state *s;
+   process_def *p;
+   exec_builtin_proc *bip;
+   llist l;
    if (!IS_SET(f->user->flags, USER_random))
      { mpz_set_ui(f->time, 1); }
    RESET_FLAG(f->flags, EXEC_instantiation);
+   hash_table_free(f->compat);
+   free(f->compat);
+   f->compat = 0;
    llist_apply(&f->chp, (llist_func*)remove_forwards, f);
    llist_apply(&f->chp, (llist_func*)run_properties, f);
+   if (!IS_SET(f->user->flags, USER_keepwu | USER_watchall))
+     { wu_procs_bypass(f); }
+   llist_init(&l);
    while (!llist_is_empty(&f->chp))
      { s = llist_idx_extract(&f->chp, 0);
+       if (IS_SET(f->user->flags, USER_prune))
+         { llist_prepend(&l, s->ps); }
        if (IS_SET(s->ps->flags, PROC_noexec)) continue;
        f->curr = s;
        f->meta_ps = s->ps;
        assert(s->obj->class == CLASS_process_def);
+       p = s->ps->p;
+       if (IS_SET(p->flags, DEF_builtin) && s->ps->b == (void*)p->cb)
+         { bip = (exec_builtin_proc*)p->nb;
+           if (bip(s->ps, f)) continue;
+         }
        exec_obj(s->obj, f);
        /* TODO: breakpoints on the process def? */
      }
+   if (IS_SET(f->user->flags, USER_prune))
+     { prune_wires(&l, f);
+       llist_free(&l, 0, 0);
+     }
  }
 
 extern void exec_immediate(llist *l, exec_info *f)
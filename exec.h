@@ -71,13 +71,17 @@ FLAGS(dbg_flags)
      NEXT_FLAG(DBG_tmp1), /* used during deadlock checks */
      NEXT_FLAG(DBG_tmp2), /* used during deadlock checks */
      NEXT_FLAG(PROC_union), /* set if process is implementing a union */
-     NEXT_FLAG(PROC_noexec) /* set on obsoleted union processes */
+     NEXT_FLAG(PROC_noexec), /* set on obsoleted union processes */
+     NEXT_FLAG(PROC_native) /* body is run by the native code of its def */
    };
 
 extern void init_exec(int app1, int app2);
  /* call at startup; pass unused object app indices */
 
-typedef struct eval_stack eval_stack;
+#define EVAL_STACK_MINSIZE 32 /* initial size of exec_info stack array */
+#define CHECK_LIST_MINSIZE 16 /* initial size of exec_info check array */
+
+typedef struct eval_stack eval_stack; /* only used for rep_vals */
 struct eval_stack
    { value_tp v;
      eval_stack *next;
@@ -99,6 +103,7 @@ FLAGS(action_flags)
      NEXT_FLAG(ACTION_pr_dn), /* down rule is enabled */
      NEXT_FLAG(ACTION_up_nxt), /* up rule will be enabled */
      NEXT_FLAG(ACTION_dn_nxt), /* down rule will be enabled */
+     NEXT_FLAG(ACTION_ready), /* suspended on a ready set */
      ACTION_is_pr = ACTION_has_up_pr | ACTION_has_dn_pr
    };
 
@@ -146,13 +151,14 @@ struct ctrl_state
      process_state *ps;
      sem_context *cxt;
      eval_stack *rep_vals; /* holds values for replicators
-                              shares nodes with f->stack usually, but
-                              when doing a parallel replication,
-                              creates and frees a single large chunk of memory
+                              nodes usually come from the free-list f->fl
+                              (see push_repval), but when doing a parallel
+                              replication, creates and frees a single large
+                              chunk of memory
                             */
      struct crit_node *crit; /* used for tracking critical cycles */
      /* data for specific stmts: */
-     int i; /* init 0.
+     long i; /* init 0.
                parallel_stmt: counter; communication: position in hs */
      dbg_flags call_flags; /* for after procedure call */
      value_tp *argv; /* argv[argc]; extra args in a call */
@@ -160,12 +166,20 @@ struct ctrl_state
      llist dep;
    };
 
+typedef struct instance_name instance_name;
+struct instance_name
+   { process_state *parent; /* closest existing ancestor */
+     const str *id; /* name relative to parent, normally without '/' */
+   };
+
 /* typedef struct process_state process_state; in value.h */
 struct process_state
    { int refcnt;
      process_def *p;
      chp_body *b;
-     str *nm; /* for reporting */
+     const char *nm; /* for reporting; 0 until needed, see ps_name() */
+     instance_name in; /* key in user_info.instances; parent is 0 for
+                          the root and for processes not in the hierarchy */
      value_tp *meta; /* meta[nr_meta]; meta-constants of process */
      int nr_meta;
      value_tp *var; /* variables of current process; == cs->var  */
@@ -177,7 +191,36 @@ struct process_state
      dbg_flags flags;
      llist children; /* llist(process_state*) */
      hash_table *accesses;  /* only used with strict checking */
+     llist ready; /* llist(ready_set) */
+   };
+
+typedef struct ready_set ready_set;
+typedef struct ready_guard ready_guard;
+struct ready_guard
+   { wire_expr *e; /* WIRE_ready, follows the value of the guard */
+     ready_set *rs;
+     int i; /* index in rs->g */
+     int pos; /* index in rs->rdy, or -1 if the guard is false */
+     guarded_cmnd *gc; /* 0 for the wait of a select_stmt */
+     sem_context *cxt; /* f->gcxt for gc */
+     value_tp *rv; /* rv[nr_rv]; replicator values, outermost first */
+     int nr_rv;
+   };
+struct ready_set
+   { parse_obj *stmt; /* select_stmt or loop_stmt */
+     action *act; /* thread suspended on this set, if any */
+     int valid; /* 0 if the guards can no longer be followed */
+     ready_guard **g; /* g[nr_g]; in the order find_true_guard visits them */
+     int nr_g;
+     int *rdy; /* rdy[nr_rdy]; indices of guards with a true probe */
+     int nr_rdy;
    };
+/* A selection whose guards are all probes or wire expressions (STMT_ready)
+ * keeps one ready_set per process.  Each guard is compiled once into a
+ * wire_expr that updates the set as the guard changes, so the true guards
+ * are known without evaluating every guard, and a suspended thread is woken
+ * by the set rather than by a dependency on each wire it read.
+ */
 
 FLAGS(exec_flags)
    { FIRST_FLAG(EVAL_assign), /* evaluating for the purpose of assignment */
@@ -196,20 +239,31 @@ FLAGS(exec_flags)
      NEXT_FLAG(EXEC_deadlock) /* f->curr is deadlocked */
    };
 
+typedef struct type_pair type_pair;
+struct type_pair /* key of exec_info.compat; ps1 = ps2 = 0 for fixed types */
+   { type *tp1; process_state *ps1;
+     type *tp2; process_state *ps2;
+   };
+
 typedef struct exec_info exec_info;
 struct exec_info
    { exec_flags flags;
      pqueue sched; /* queued actions */
-     llist check; /* actions to be checked */
+     action **check; /* check[nr_check]: actions to be checked */
+     int nr_check, max_check;
      llist susp_perm; /* permanently suspended statements */
      llist chp; /* non meta body actions stored here during instantiation */
      ctrl_state *curr; /* current state */
      ctrl_state *prev; /* previous state */
      process_state *meta_ps;
      mpz_t time; /* current time */
-     eval_stack *stack; /* for expr eval */
-     eval_stack *fl; /* free-list for stack */
+     value_tp *stack; /* stack[nr_stack]: for expr eval */
+     int nr_stack, max_stack;
+     eval_stack *fl; /* free-list for rep_vals */
      value_tp *val; /* target of range check */
+     value_tp pkv; /* element of a packed array, see packed_reval() */
+     value_tp *pk; /* packed array that pkv is assigned to, or 0 */
+     long pk_idx; /* index of pkv in pk */
      void *err_obj; /* obj for errors, in range check or strict checks */
      wire_expr *e;
      guarded_cmnd *gc; /* for find_true_guard */
@@ -223,7 +277,10 @@ struct exec_info
      struct property_info *prop; /* stores properties */
      hash_table *crit_map; /* used for tracking critical cycles */
      struct crit_node *crit; /* also used for tracking critical cycles */
+     hash_table *compat; /* type_pairs found compatible during instantiation;
+                            see type_compatible_exec */
      long ecount; /* Used for energy estimates */
+     long nr_impure; /* nr of calls that are not pure; see eval_call */
      void *custom; /* Reserved for use by chpsim add-ons */
    };
      
@@ -281,6 +338,10 @@ extern process_state *new_process_state(exec_info *f, const str *nm);
     is returned instead.
  */
 
+extern process_state *new_child_process_state
+(exec_info *f, process_state *prnt, const str *id);
+ /* Same as new_process_state(), for the instance named id in prnt */
+
 extern void free_process_state(process_state *ps, exec_info *f);
  /* Deallocate the process state. If refcnt is not 0, then variables
     etc. are deallocated but ps itself is not (this is used for user
@@ -351,6 +412,14 @@ extern void exec_modules(llist *l, exec_info *f);
 typedef void exec_builtin_func(function_def *x, exec_info *f);
  /* Type of function for builtin functions */
 
+typedef int exec_builtin_proc(process_state *ps, exec_info *f);
+ /* Type of function for native implementations of processes.  Called
+    instead of starting the chp body of ps; return 0 to decline, in which
+    case the chp body is executed as usual.  If the function sets
+    PROC_native and schedules ps->cs, it is called again to execute each
+    step of ps, and then returns an exec_return like an exec function.
+ */
+
 extern int app_exec;
 #define set_exec(C) set_app(CLASS_ ## C, app_exec, (obj_func*)exec_ ## C)
  /* To set exec_abc as exec function for class abc */
@@ -885,7 +885,9 @@ static void *sem_call(call *x, sem_info *f)
    if (x->d->ret)
      { x->tp = x->d->ret->tp; }
    else
-     { SET_FLAG(x->flags, EXPR_unconst); }
+     { SET_FLAG(x->flags, EXPR_unconst);
+       sem_not_seq(f); /* procedure call */
+     }
    if (IS_SET(x->d->flags, DEF_builtin)) /* For random(), etc */
      { SET_FLAG(x->flags, EXPR_unconst); }
    if (IS_SET(x->flags, EXPR_nocexpr))
@@ -1026,8 +1028,17 @@ static void *sem_type_expr(type_expr *x, sem_info *f)
  *****************************************************************************/
 
 extern long eval_rep_common(rep_common *x, value_tp *v, exec_info *f)
- /* set v to value of low replicator bound, returns # of values in bounds */
+ /* set v to value of low replicator bound, returns # of values in bounds.
+    Bounds that fit in a long are kept as REP_int, so v can be incremented
+    in place; if they do not depend on meta parameters or replicators,
+    they are only evaluated once.
+ */
  { value_tp lval, hval, dval;
+   if (x->n > 0)
+     { v->rep = REP_int;
+       v->v.i = x->lo;
+       return x->n;
+     }
    eval_expr(x->h, f);
    eval_expr(x->l, f);
    pop_value(&lval, f);
@@ -1040,10 +1051,17 @@ extern long eval_rep_common(rep_common *x, value_tp *v, exec_info *f)
    copy_value_tp(v, &lval, f);
    dval = int_sub(&hval, &lval, f);
    int_simplify(&dval, f);
-   if (dval.rep != REP_int || dval.v.i > ARRAY_REP_MAXSIZE)
+   if (dval.rep != REP_int || dval.v.i >= MAX_INT_REP)
      { clear_value_tp(v, f);
-       exec_error(f, x, "Implementation limit exceeded: Replication length "
-                  "%v > %ld", vstr_val, &dval, (long)ARRAY_REP_MAXSIZE);
+       exec_error(f, f->curr->obj, "Implementation limit exceeded: "
+                  "Replication length %v > %ld",
+                  vstr_val, &dval, (long)MAX_INT_REP - 1);
+     }
+   if (v->rep == REP_int &&
+       !IS_SET(x->l->flags, EXPR_all_const) &&
+       !IS_SET(x->h->flags, EXPR_all_const))
+     { x->lo = v->v.i;
+       x->n = dval.v.i + 1;
      }
    return dval.v.i + 1;
  } 
@@ -1066,13 +1084,9 @@ extern int equal_value(value_tp *v, value_tp *w, exec_info *f, void *obj)
             if (w->rep == REP_int)
               { r = (v->v.i == w->v.i); }
             else
-              { r = !mpz_cmp_si(w->v.z->z, v->v.i); }
+              { r = !int_cmp(v, w, f); }
        break;
-       case REP_z:
-            if (w->rep == REP_z)
-              { r = !mpz_cmp(v->v.z->z, w->v.z->z); }
-            else
-              { r = !mpz_cmp_si(v->v.z->z, w->v.i); }
+       case REP_z: case REP_wide: r = !int_cmp(v, w, f);
        break;
        case REP_symbol: r = (v->v.s == w->v.s);
        break;
@@ -1093,15 +1107,142 @@ extern int equal_value(value_tp *v, value_tp *w, exec_info *f, void *obj)
    return r;
  }
 
+/********** wide integers ***************************************************/
+
+/* The REP_wide operations work on arrays of WIDE_REP_NRWORD words, which
+   can hold any sum or bitwise combination of two REP_wide values without
+   overflow.  int_set_words() then picks the representation of the result.
+*/
+
+static const ulong wide_one[WIDE_REP_NRWORD] = { 1 };
+
+static int int_words(value_tp *v, ulong *w)
+ /* If v is REP_int or REP_wide, set the words w to its value and return 1;
+    otherwise return 0.
+ */
+ { int i;
+   if (v->rep == REP_int)
+     { w[0] = (ulong)v->v.i;
+       for (i = 1; i < WIDE_REP_NRWORD; i++)
+         { w[i] = v->v.i < 0? ~0UL : 0; }
+       return 1;
+     }
+   else if (v->rep == REP_wide)
+     { memcpy(w, v->v.wd->w, sizeof(v->v.wd->w));
+       return 1;
+     }
+   return 0;
+ }
+
+static void int_set_words(value_tp *x, const ulong *w, exec_info *f)
+ /* Set x (which has no value) to the value of the words w, as REP_int if it
+    fits, else as REP_wide if it fits, else as REP_z.
+ */
+ { int i;
+   ulong sx = (long)w[0] < 0? ~0UL : 0;
+   for (i = 1; i < WIDE_REP_NRWORD && w[i] == sx; i++) ;
+   if (i == WIDE_REP_NRWORD)
+     { x->rep = REP_int;
+       x->v.i = (long)w[0];
+     }
+   else if (!w[WIDE_REP_NRWORD - 1] || !~w[WIDE_REP_NRWORD - 1])
+     { x->rep = REP_wide;
+       x->v.wd = new_wide_value(f);
+       memcpy(x->v.wd->w, w, sizeof(x->v.wd->w));
+     }
+   else
+     { x->rep = REP_z;
+       x->v.z = new_z_value(f);
+       wide_get_z(x->v.z->z, w);
+     }
+ }
+
+static void wide_add(ulong *w, const ulong *v, int sub)
+ /* w = w + v, or w = w - v if sub */
+ { int i;
+   ulong a, s, c = sub;
+   for (i = 0; i < WIDE_REP_NRWORD; i++)
+     { a = sub? ~v[i] : v[i];
+       s = w[i] + a;
+       w[i] = s + c;
+       c = (s < a) | (w[i] < s);
+     }
+ }
+
+static void wide_neg(ulong *w)
+ /* w = -w */
+ { int i;
+   ulong c = 1;
+   for (i = 0; i < WIDE_REP_NRWORD; i++)
+     { w[i] = ~w[i] + c;
+       c = c && !w[i];
+     }
+ }
+
+static int wide_cmp(const ulong *w, const ulong *v)
+ /* Return 0 if w == v, <0 if w < v, >0 if w > v */
+ { int i = WIDE_REP_NRWORD - 1;
+   if (w[i] != v[i])
+     { return (long)w[i] < (long)v[i]? -1 : 1; }
+   while (i)
+     { i--;
+       if (w[i] != v[i])
+         { return w[i] < v[i]? -1 : 1; }
+     }
+   return 0;
+ }
+
+static void wide_extract(ulong *r, const ulong *w, long lidx, long n)
+ /* r = bits lidx .. lidx+n-1 of w; Pre: n <= WIDE_REP_NRBITS, r != w */
+ { long i, k = lidx / INT_REP_NRBITS, b = lidx % INT_REP_NRBITS;
+   ulong lo, hi, sx = (long)w[WIDE_REP_NRWORD - 1] < 0? ~0UL : 0;
+   for (i = 0; i < WIDE_REP_NRWORD; i++)
+     { lo = k + i < WIDE_REP_NRWORD? w[k + i] : sx;
+       hi = k + i + 1 < WIDE_REP_NRWORD? w[k + i + 1] : sx;
+       r[i] = b? (lo >> b) | (hi << (INT_REP_NRBITS - b)) : lo;
+       if (n <= i * INT_REP_NRBITS)
+         { r[i] = 0; }
+       else if (n < (i + 1) * INT_REP_NRBITS)
+         { r[i] &= (1UL << (n - i * INT_REP_NRBITS)) - 1; }
+     }
+ }
+
+static void wide_shift_left(ulong *r, const ulong *w, long lidx)
+ /* r = w * 2^lidx; Pre: no overflow, r != w */
+ { long i, k = lidx / INT_REP_NRBITS, b = lidx % INT_REP_NRBITS;
+   for (i = 0; i < WIDE_REP_NRWORD; i++)
+     { r[i] = i >= k? w[i - k] << b : 0;
+       if (b && i > k)
+         { r[i] |= w[i - k - 1] >> (INT_REP_NRBITS - b); }
+     }
+ }
+
+static int int_sgn(value_tp *x)
+ /* Pre: x->rep is REP_int, REP_wide or REP_z.
+    Return <0, 0 or >0 if x is negative, 0 or positive.
+ */
+ { if (x->rep == REP_int)
+     { return x->v.i < 0? -1 : x->v.i > 0; }
+   else if (x->rep == REP_wide)
+     { return (long)x->v.wd->w[WIDE_REP_NRWORD - 1] < 0? -1 : 1; }
+   return mpz_sgn(x->v.z->z);
+ }
+
 extern void int_simplify(value_tp *x, exec_info *f)
- /* if possible, replace x by REP_int rather than REP_z */
+ /* if possible, replace x by REP_int or REP_wide rather than REP_z */
  { long i;
-   if (x->rep == REP_z && mpz_fits_slong_p(x->v.z->z))
+   ulong w[WIDE_REP_NRWORD];
+   if (x->rep != REP_z) return;
+   if (mpz_fits_slong_p(x->v.z->z))
      { i = mpz_get_si(x->v.z->z);
        clear_value_tp(x, f);
        x->rep = REP_int;
        x->v.i = i;
      }
+   else if (wide_set_z(w, x->v.z->z))
+     { clear_value_tp(x, f);
+       int_set_words(x, w, f);
+     }
  }
 
 extern value_tp int_add(value_tp *l, value_tp *r, exec_info *f)
@@ -1110,21 +1251,25 @@ extern value_tp int_add(value_tp *l, value_tp *r, exec_info *f)
  */
  { value_tp x, *tmp;
    long li, ri, sign;
+   ulong lw[WIDE_REP_NRWORD], rw[WIDE_REP_NRWORD];
    if (l->rep == REP_int && r->rep == REP_int)
      { x.rep = REP_int;
        li = l->v.i; ri = r->v.i;
        x.v.i = li + ri;
        sign = x.v.i & INT_REP_SIGN;
-       if ((INT_REP_SIGN & li) != sign && (INT_REP_SIGN & ri) != sign)
-         { /* overflow */
-           x.rep = REP_z;
-           x.v.z = new_z_value(f);
-           mpz_set_si(x.v.z->z, li);
-           l = &x;
-         }
-       else
+       if ((INT_REP_SIGN & li) == sign || (INT_REP_SIGN & ri) == sign)
          { return x; }
+       /* else overflow */
+     }
+   if (int_words(l, lw) && int_words(r, rw))
+     { wide_add(lw, rw, 0);
+       clear_value_tp(l, f);
+       clear_value_tp(r, f);
+       int_set_words(&x, lw, f);
+       return x;
      }
+   int_unwide(l, f);
+   int_unwide(r, f);
    if (l->rep == REP_int)
      { tmp = l; l = r; r = tmp; }
    /* l->rep == REP_z */
@@ -1140,6 +1285,7 @@ extern value_tp int_add(value_tp *l, value_tp *r, exec_info *f)
      { mpz_add(x.v.z->z, x.v.z->z, r->v.z->z);
        clear_value_tp(r, f);
      }
+   int_simplify(&x, f);
    return x;
  }
 
@@ -1150,21 +1296,25 @@ extern value_tp int_sub(value_tp *l, value_tp *r, exec_info *f)
  { value_tp x, *tmp;
    long li, ri, sign;
    int neg = 0; /* if 1, then compute -(r - l) */
+   ulong lw[WIDE_REP_NRWORD], rw[WIDE_REP_NRWORD];
    if (l->rep == REP_int && r->rep == REP_int)
      { x.rep = REP_int;
        li = l->v.i; ri = r->v.i;
        x.v.i = li - ri;
        sign = x.v.i & INT_REP_SIGN;
-       if ((INT_REP_SIGN & li) != sign && (INT_REP_SIGN & ri) == sign)
-         { /* overflow */
-           x.rep = REP_z;
-           x.v.z = new_z_value(f);
-           mpz_set_si(x.v.z->z, li);
-           l = &x;
-         }
-       else
+       if ((INT_REP_SIGN & li) == sign || (INT_REP_SIGN & ri) != sign)
          { return x; }
+       /* else overflow */
+     }
+   if (int_words(l, lw) && int_words(r, rw))
+     { wide_add(lw, rw, 1);
+       clear_value_tp(l, f);
+       clear_value_tp(r, f);
+       int_set_words(&x, lw, f);
+       return x;
      }
+   int_unwide(l, f);
+   int_unwide(r, f);
    if (l->rep == REP_int)
      { tmp = l; l = r; r = tmp; neg = 1; }
    /* l->rep == REP_z */
@@ -1182,6 +1332,7 @@ extern value_tp int_sub(value_tp *l, value_tp *r, exec_info *f)
      { mpz_sub(x.v.z->z, x.v.z->z, r->v.z->z);
        clear_value_tp(r, f);
      }
+   int_simplify(&x, f);
    return x;
  }
 
@@ -1189,13 +1340,13 @@ extern void int_inc(value_tp *x, exec_info *f)
  /* Pre: x->rep
     increment x in place
  */
- { if (x->rep == REP_int)
-     { x->v.i++;
-       if (x->v.i == INT_REP_SIGN)
-         { x->rep = REP_z;
-           x->v.z = new_z_value(f);
-           mpz_set_si(x->v.z->z, INT_REP_SIGN);
-         }
+ { ulong w[WIDE_REP_NRWORD];
+   if (x->rep == REP_int && x->v.i != MAX_INT_REP)
+     { x->v.i++; }
+   else if (int_words(x, w))
+     { wide_add(w, wide_one, 0);
+       clear_value_tp(x, f);
+       int_set_words(x, w, f);
      }
    else
      { assert(x->rep == REP_z);
@@ -1208,13 +1359,13 @@ extern void int_dec(value_tp *x, exec_info *f)
  /* Pre: x->rep
     decrement x in place
  */
- { if (x->rep == REP_int)
-     { x->v.i--;
-       if (x->v.i == ~INT_REP_SIGN)
-         { x->rep = REP_z;
-           x->v.z = new_z_value(f);
-           mpz_set_si(x->v.z->z, ~INT_REP_SIGN);
-         }
+ { ulong w[WIDE_REP_NRWORD];
+   if (x->rep == REP_int && x->v.i != MIN_INT_REP)
+     { x->v.i--; }
+   else if (int_words(x, w))
+     { wide_add(w, wide_one, 1);
+       clear_value_tp(x, f);
+       int_set_words(x, w, f);
      }
    else
      { assert(x->rep == REP_z);
@@ -1264,6 +1415,8 @@ static value_tp int_mul(value_tp *l, value_tp *r, exec_info *f)
            l = &x;
          }
      }
+   int_unwide(l, f);
+   int_unwide(r, f);
    if (l->rep == REP_int)
      { tmp = l; l = r; r = tmp; }
    /* l->rep == REP_z */
@@ -1274,6 +1427,7 @@ static value_tp int_mul(value_tp *l, value_tp *r, exec_info *f)
      { mpz_mul(x.v.z->z, x.v.z->z, r->v.z->z);
        clear_value_tp(r, f);
      }
+   int_simplify(&x, f);
    return x;
  }
 
@@ -1310,6 +1464,8 @@ static value_tp int_divmod(value_tp *l, value_tp *r, token_tp op, exec_info *f)
        return x;
      }
  use_z:
+   int_unwide(l, f);
+   int_unwide(r, f);
    if (l->rep == REP_int)
      { x.rep = REP_z;
        x.v.z = new_z_value(f);
@@ -1339,6 +1495,7 @@ static value_tp int_divmod(value_tp *l, value_tp *r, token_tp op, exec_info *f)
          { mpz_mod(x.v.z->z, x.v.z->z, r->v.z->z); }
        clear_value_tp(r, f);
      }
+   int_simplify(&x, f);
    return x;
  }
 
@@ -1348,6 +1505,8 @@ static value_tp int_bitwise(value_tp *l, value_tp *r, token_tp op,exec_info *f)
  */
  { value_tp x;
    long li, ri;
+   int i;
+   ulong lw[WIDE_REP_NRWORD], rw[WIDE_REP_NRWORD];
    li = l->v.i; ri = r->v.i;
    if (l->rep == REP_int && r->rep == REP_int)
      { x.rep = REP_int;
@@ -1359,6 +1518,23 @@ static value_tp int_bitwise(value_tp *l, value_tp *r, token_tp op,exec_info *f)
          { x.v.i = li ^ ri; }
        return x;
      }
+   if (int_words(l, lw) && int_words(r, rw))
+     { for (i = 0; i < WIDE_REP_NRWORD; i++)
+         { if (op == '&')
+             { lw[i] &= rw[i]; }
+           else if (op == '|')
+             { lw[i] |= rw[i]; }
+           else
+             { lw[i] ^= rw[i]; }
+         }
+       clear_value_tp(l, f);
+       clear_value_tp(r, f);
+       int_set_words(&x, lw, f);
+       return x;
+     }
+   int_unwide(l, f);
+   int_unwide(r, f);
+   li = l->v.i; ri = r->v.i;
    x.rep = REP_z;
    if (l->rep == REP_int)
      { x.v.z = new_z_value(f);
@@ -1378,6 +1554,7 @@ static value_tp int_bitwise(value_tp *l, value_tp *r, token_tp op,exec_info *f)
    else
      { mpz_xor(x.v.z->z, x.v.z->z, r->v.z->z); }
    clear_value_tp(r, f);
+   int_simplify(&x, f);
    return x;
  }
 
@@ -1390,6 +1567,8 @@ static value_tp int_exponentiate
    ulong yi;
    int_simplify(y, f);
    int_simplify(x, f);
+   int_unwide(y, f);
+   int_unwide(x, f);
    if ((y->rep == REP_int && y->v.i < 0) ||
        (y->rep == REP_z && mpz_sgn(y->v.z->z) < 0))
      { clear_value_tp(x, f);
@@ -1453,6 +1632,8 @@ extern long int_log2(value_tp *x, exec_info *f)
        x->v.z = new_z_value(f);
        mpz_set_si(x->v.z->z,  xv);
      }
+   else
+     { int_unwide(x, f); }
    ret = mpz_sizeinbase(x->v.z->z, 2);
    clear_value_tp(x, f);
    return ret;
@@ -1500,7 +1681,23 @@ extern int int_cmp(value_tp *x, value_tp *y, exec_info *f)
  */
  { int c = 0;
    long xi, yi;
-   if (x->rep == REP_int)
+   ulong xw[WIDE_REP_NRWORD], yw[WIDE_REP_NRWORD];
+   mpz_t z;
+   if (x->rep == REP_wide || y->rep == REP_wide)
+     { if (int_words(x, xw) && int_words(y, yw))
+         { return wide_cmp(xw, yw); }
+       mpz_init(z);
+       if (x->rep == REP_z)
+         { wide_get_z(z, y->v.wd->w);
+           c = mpz_cmp(x->v.z->z, z);
+         }
+       else
+         { wide_get_z(z, x->v.wd->w);
+           c = mpz_cmp(z, y->v.z->z);
+         }
+       mpz_clear(z);
+     }
+   else if (x->rep == REP_int)
      { if (y->rep == REP_int)
          { xi = x->v.i; yi = y->v.i;
            /* return xi - yi; might have overflow */
@@ -1524,66 +1721,66 @@ extern int int_cmp(value_tp *x, value_tp *y, exec_info *f)
  }
 
 static void int_compare(binary_expr *x, exec_info *f)
- /* Pre: x->l, x->r have been eval'd; x is comparison (not =, !=) */
- { value_tp xval, lval, rval;
+ /* Pre: x is comparison (not =, !=) */
+ { value_tp xval, lval, rval, *lv, *rv;
    long c;
-   pop_value(&rval, f);
-   pop_value(&lval, f);
-   if (!lval.rep || !rval.rep)
-     { xval.rep = REP_none;
-       push_value(&xval, f);
-       return;
-     }
-   xval.rep = REP_bool;
-   c = int_cmp(&lval, &rval, f);
-   clear_value_tp(&lval, f);
-   clear_value_tp(&rval, f);
-   switch(x->op_sym)
-     { case '<': xval.v.i = (c < 0);
-       break;
-       case SYM_lte: xval.v.i = (c <= 0);
-       break;
-       case '>': xval.v.i = (c > 0);
-       break;
-       case SYM_gte: xval.v.i = (c >= 0);
-       break;
-       default: assert(!"Illegal op symbol");
-       break;
+   lv = eval_borrow(x->l, &lval, f);
+   rv = eval_borrow(x->r, &rval, f);
+   if (!lv->rep || !rv->rep)
+     { xval.rep = REP_none; }
+   else
+     { xval.rep = REP_bool;
+       c = int_cmp(lv, rv, f);
+       switch(x->op_sym)
+         { case '<': xval.v.i = (c < 0);
+           break;
+           case SYM_lte: xval.v.i = (c <= 0);
+           break;
+           case '>': xval.v.i = (c > 0);
+           break;
+           case SYM_gte: xval.v.i = (c >= 0);
+           break;
+           default: assert(!"Illegal op symbol");
+           break;
+         }
      }
+   release_borrow(rv, &rval, f);
+   release_borrow(lv, &lval, f);
    push_value(&xval, f);
  }
 
 static void bool_arithmetic(binary_expr *x, exec_info *f)
- /* Pre: x->l, x->r have been eval'd; x is bool, bool -> bool (not =, !=) */
- { value_tp xval, lval, rval;
+ /* Pre: x is bool, bool -> bool (not =, !=) */
+ { value_tp xval, lval, rval, *lv, *rv;
    int li, ri;
-   pop_value(&rval, f);
-   pop_value(&lval, f);
-   if (!lval.rep || !rval.rep)
-     { xval.rep = REP_none;
-       push_value(&xval, f);
-       return;
-     }
-   xval.rep = REP_bool;
-   li = lval.v.i; ri = rval.v.i;
-   switch(x->op_sym)
-     { case '<': xval.v.i = (li < ri);
-       break;
-       case SYM_lte: xval.v.i = (li <= ri);
-       break;
-       case '>': xval.v.i = (li > ri);
-       break;
-       case SYM_gte: xval.v.i = (li >= ri);
-       break;
-       case '&': xval.v.i = li & ri;
-       break;
-       case '|': xval.v.i = li | ri;
-       break;
-       case KW_xor: xval.v.i = li ^ ri;
-       break;
-       default: assert(!"Illegal op symbol");
-       break;
+   lv = eval_borrow(x->l, &lval, f);
+   rv = eval_borrow(x->r, &rval, f);
+   if (!lv->rep || !rv->rep)
+     { xval.rep = REP_none; }
+   else
+     { xval.rep = REP_bool;
+       li = lv->v.i; ri = rv->v.i;
+       switch(x->op_sym)
+         { case '<': xval.v.i = (li < ri);
+           break;
+           case SYM_lte: xval.v.i = (li <= ri);
+           break;
+           case '>': xval.v.i = (li > ri);
+           break;
+           case SYM_gte: xval.v.i = (li >= ri);
+           break;
+           case '&': xval.v.i = li & ri;
+           break;
+           case '|': xval.v.i = li | ri;
+           break;
+           case KW_xor: xval.v.i = li ^ ri;
+           break;
+           default: assert(!"Illegal op symbol");
+           break;
+         }
      }
+   release_borrow(rv, &rval, f);
+   release_borrow(lv, &lval, f);
    push_value(&xval, f);
  }
 
@@ -1627,54 +1824,50 @@ static void concat_array(binary_expr *x, exec_info *f)
  }
 
 static void eval_binary_expr(binary_expr *x, exec_info *f)
- { value_tp xval, lval, rval;
-   eval_expr(x->l, f);
-   eval_expr(x->r, f);
+ { value_tp xval, lval, rval, *lv, *rv;
    if (x->op_sym == '=' || x->op_sym == SYM_neq)
-     { pop_value(&rval, f);
-       pop_value(&lval, f);
-       if (!lval.rep || !rval.rep)
+     { /* operands are only inspected, so they need not be aliased */
+       lv = eval_borrow(x->l, &lval, f);
+       rv = eval_borrow(x->r, &rval, f);
+       if (!lv->rep || !rv->rep)
          { xval.rep = REP_none; }
        else
          { xval.rep = REP_bool;
-           xval.v.i = equal_value(&lval, &rval, f, x);
+           xval.v.i = equal_value(lv, rv, f, x);
            if (x->op_sym == SYM_neq)
              { xval.v.i = 1 - xval.v.i; }
          }
+       release_borrow(rv, &rval, f);
+       release_borrow(lv, &lval, f);
        push_value(&xval, f);
-       clear_value_tp(&lval, f);
-       clear_value_tp(&rval, f);
      }
-   else if (x->tp.kind == TP_int)
-     { int_arithmetic(x, f); }
-   else if (x->l->tp.kind == TP_int)
+   else if (x->tp.kind != TP_int && x->l->tp.kind == TP_int)
      { int_compare(x, f); }
-   else if (x->l->tp.kind == TP_bool)
+   else if (x->tp.kind != TP_int && x->l->tp.kind == TP_bool)
      { bool_arithmetic(x, f); }
-   else if (x->op_sym == SYM_concat)
-     { concat_array(x, f); }
    else
-     { assert(!"Illegal binary operator"); }
+     { eval_expr(x->l, f);
+       eval_expr(x->r, f);
+       if (x->tp.kind == TP_int)
+         { int_arithmetic(x, f); }
+       else if (x->op_sym == SYM_concat)
+         { concat_array(x, f); }
+       else
+         { assert(!"Illegal binary operator"); }
+     }
  }
 
 static void eval_rep_expr(rep_expr *x, exec_info *f)
- { value_tp xval, lval, hval, nval;
-   int i, j = 0, k = 0, n = 0;
+ { value_tp xval, ival, nval;
+   long i, m, j, k = 0, n = 0;
    void (*cp)(value_tp *, value_tp *, exec_info *);
-   eval_expr(x->r.l, f);
-   eval_expr(x->r.h, f);
-   pop_value(&hval, f);
-   pop_value(&lval, f);
-   if (int_cmp(&hval, &lval, f) < 0)
-     { exec_error(f, x,
-           "Replication lower bound %v = %v exceeds upper bound %v = %v",
-           vstr_obj, x->r.l, vstr_val, lval, vstr_obj, x->r.h, vstr_val, hval);
-     }
+   m = eval_rep_common(&x->r, &ival, f);
+   push_repval(&ival, f->curr, f);
    if (x->rep_sym == SYM_concat)
-     { push_repval(&hval, f->curr, f);
-       xval.rep = REP_array;
-       while (int_cmp(&lval, &f->curr->rep_vals->v, f) <= 0)
-         { eval_expr(x->v, f);
+     { xval.rep = REP_array;
+       for (j = 0; j < m; j++)
+         { if (j > 0) int_inc(&f->curr->rep_vals->v, f);
+           eval_expr(x->v, f);
            pop_value(&nval, f);
            if (!nval.rep)
              { xval.rep = REP_none; }
@@ -1683,7 +1876,7 @@ static void eval_rep_expr(rep_expr *x, exec_info *f)
                n += nval.v.l->size;
                if (n > ARRAY_REP_MAXSIZE)
                  { exec_error(f, x, "Implementation limit exceeded: Array size"
-                              " %ld > %ld", (long)n, (long)ARRAY_REP_MAXSIZE);
+                              " %ld > %ld", n, (long)ARRAY_REP_MAXSIZE);
                  }
                else if (nval.v.l->size > 0)
                  { push_value(&nval, f);
@@ -1692,7 +1885,6 @@ static void eval_rep_expr(rep_expr *x, exec_info *f)
                else
                  { clear_value_tp(&nval, f); }
              }
-           int_dec(&f->curr->rep_vals->v, f);
          }
        if (!xval.rep)
          { for (i = 0; i < k; i++)
@@ -1702,24 +1894,23 @@ static void eval_rep_expr(rep_expr *x, exec_info *f)
          }
        else
          { xval.v.l = new_value_list(n, f);
-           while (j < n)
+           j = n; /* the last part is on top of the stack */
+           while (j > 0)
              { pop_value(&nval, f);
                if (nval.v.l->refcnt == 1)
                  { cp = copy_and_clear; }
                else
                  { cp = alias_value_tp; }
-               for (i = 0; i < nval.v.l->size; i++, j++)
-                 { cp(&xval.v.l->vl[j], &nval.v.l->vl[i], f); }
+               for (i = nval.v.l->size - 1; i >= 0; i--)
+                 { cp(&xval.v.l->vl[--j], &nval.v.l->vl[i], f); }
                clear_value_tp(&nval, f);
              }
          }
-       hval = lval;
      }
    else
-     { push_repval(&lval, f->curr, f);
-       eval_expr(x->v, f);
+     { eval_expr(x->v, f);
        pop_value(&xval, f);
-       while (int_cmp(&f->curr->rep_vals->v, &hval, f) < 0)
+       for (j = 1; j < m; j++)
          { int_inc(&f->curr->rep_vals->v, f);
            eval_expr(x->v, f);
            pop_value(&nval, f);
@@ -1752,13 +1943,14 @@ static void eval_rep_expr(rep_expr *x, exec_info *f)
          }
      }
    push_value(&xval, f);
-   pop_repval(&lval, f->curr, f);
-   clear_value_tp(&lval, f);
-   clear_value_tp(&hval, f);
+   pop_repval(&ival, f->curr, f);
+   clear_value_tp(&ival, f);
  }
 
 static void eval_prefix_expr(prefix_expr *x, exec_info *f)
  { value_tp xval, rval;
+   ulong w[WIDE_REP_NRWORD];
+   int i;
    eval_expr(x->r, f);
    pop_value(&rval, f);
    if (!rval.rep)
@@ -1784,15 +1976,27 @@ static void eval_prefix_expr(prefix_expr *x, exec_info *f)
                  xval.v.i = - rval.v.i;
                }
            }
+         else if (int_words(&rval, w))
+           { wide_neg(w);
+             clear_value_tp(&rval, f);
+             int_set_words(&xval, w, f);
+           }
          else
            { copy_and_clear(&xval, &rval, f);
              mpz_neg(xval.v.z->z, xval.v.z->z);
+             int_simplify(&xval, f);
            }
        break;
        case '~': if (rval.rep == REP_int)
                    { xval.rep = REP_int;
                      xval.v.i = ~rval.v.i;
                    }
+                 else if (int_words(&rval, w))
+                   { for (i = 0; i < WIDE_REP_NRWORD; i++)
+                       { w[i] = ~w[i]; }
+                     clear_value_tp(&rval, f);
+                     int_set_words(&xval, w, f);
+                   }
                  else if (rval.rep == REP_z)
                    { copy_and_clear(&xval, &rval, f);
                      mpz_com(xval.v.z->z, xval.v.z->z);
@@ -1920,21 +2124,27 @@ static int _free_wprobe(wire_expr *e, wire_value *w)
 
 static void free_wprobe(wire_value *w, exec_info *f)
  { if (IS_SET(w->flags, WIRE_has_dep))
-     { llist_free(&w->u.dep, (llist_func*)_free_wprobe, w); }
+     { dep_list_extract(&w->u.dep, (dep_func*)_free_wprobe, w);
+       dep_list_free(&w->u.dep);
+     }
  }
 
-static void *_copy_wprobe(wire_expr *e, wire_value *w)
+static void _copy_wprobe(wire_expr *e, wire_value *w)
  { e->refcnt++;
    if ((w->flags ^ (e->flags >> WIRE_vd_shft)) & WIRE_value)
      { e->valcnt++; }
    llist_prepend(&e->u.act->cs->dep, w);
-   return e;
+   dep_list_add(&w->u.dep, e);
  }
 
 static void copy_wprobe(wire_value *w1, wire_value *w2, exec_info *f)
- { w1->flags = w2->flags;
+ { int i;
+   w1->flags = w2->flags;
    if (IS_SET(w2->flags, WIRE_has_dep))
-     { w1->u.dep = llist_copy(&w2->u.dep, (llist_func_p*)_copy_wprobe, w1); }
+     { dep_list_init(&w1->u.dep);
+       for (i = 0; i < w2->u.dep.nr; i++)
+         { _copy_wprobe(DEP_IDX(&w2->u.dep, i), w1); }
+     }
  }
 
 extern void port_to_array(value_tp *v, expr *x, exec_info *f)
@@ -1948,6 +2158,8 @@ extern void port_to_array(value_tp *v, expr *x, exec_info *f)
    port_value *p, *pp, *vp, *vpp;
    int i;
    vp = v->v.p; vpp = v->v.p->p;
+   ready_wprobe_drop(&vp->wprobe, f);
+   ready_wprobe_drop(&vpp->wprobe, f);
    assert(vp->wpp == &vpp->wprobe); /* TODO: handle this case */
    assert(vpp->wpp == &vp->wprobe); /* TODO: handle this case */
    assert(vpp->wprobe.refcnt<=2);
@@ -1970,6 +2182,10 @@ extern void port_to_array(value_tp *v, expr *x, exec_info *f)
          { p->v.rep = REP_bool;
            p->v.v.i = ((vp->v.v.i & (1 << i)) != 0);
          }
+       else if (vp->v.rep == REP_wide)
+         { p->v.rep = REP_bool;
+           p->v.v.i = wide_tstbit(vp->v.v.wd->w, i);
+         }
        else if (vp->v.rep == REP_z)
          { p->v.rep = REP_bool;
            p->v.v.i = mpz_tstbit(vp->v.v.z->z, i);
@@ -2083,14 +2299,14 @@ static void eval_array_subscript(array_subscript *x, exec_info *f)
  }
 
 static void *reval_array_subscript(array_subscript *x, exec_info *f)
- { value_tp xval, *xxval, lval, hval;
+ { value_tp xval, *xxval, lval, hval, *ve;
    long idx;
    eval_array_bounds(x->x, &lval, &hval, f);
    idx = eval_array_index(x->idx, &lval, &hval, f);
    clear_value_tp(&lval, f);
    clear_value_tp(&hval, f);
    xxval = reval_expr(x->x, f);
-   if (!xxval->rep) force_value(xxval, x->x, f); // TODO: stop using force_value
+   if (!xxval->rep) force_value_packed(xxval, x->x, f); // TODO: stop using force_value
    else if (xxval->rep == REP_port)
      { if (!xxval->v.p->p) /* TODO: What to do here? */
          { return xxval; }
@@ -2098,7 +2314,16 @@ static void *reval_array_subscript(array_subscript *x, exec_info *f)
      }
    else if (xxval->rep == REP_union)
      { exec_error(f, x, "Use of conflicting decompositions"); }
+   if (xxval->rep == REP_packed)
+     { if (!IS_SET(x->flags, EXPR_ifrchk))
+         { return packed_reval(xxval, idx, f); }
+       ve = packed_elem(xxval, idx, f);
+       strict_check_elem(x->x, xxval, f);
+       return ve;
+     }
    assert(xxval->rep == REP_array);
+   if (IS_SET(f->flags, EVAL_assign) || IS_SET(x->flags, EXPR_ifrchk))
+     { unshare_value(xxval, f); }
    if (IS_SET(x->flags, EXPR_ifrchk))
      { strict_check_elem(x->x, xxval, f); }
    return &xxval->v.l->vl[idx];
@@ -2124,6 +2349,7 @@ static void *connect_array_subscript(array_subscript *x, exec_info *f)
    else if (xxval->rep == REP_union)
      { exec_error(f, x, "Use of conflicting decompositions"); }
    assert(xxval->rep == REP_array);
+   unshare_value(xxval, f);
    return &xxval->v.l->vl[idx];
  }
 
@@ -2137,13 +2363,12 @@ static long eval_bit_index(expr *idx, exec_info *f)
    if (!idxval.rep)
      { exec_error(f, idx, "Unknown index [%v]", vstr_obj, idx); }
    int_simplify(&idxval, f);
-   if ((idxval.rep == REP_int && idxval.v.i < 0) ||
-       (idxval.rep == REP_z && mpz_sgn(idxval.v.z->z) < 0))
+   if (int_sgn(&idxval) < 0)
      { exec_error(f, idx, "Selecting bit [%v] = %v < 0", vstr_obj,
                   idx, vstr_val, &idxval);
      }
    if ((idxval.rep == REP_int && idxval.v.i > INT_REP_MAXBITS) ||
-        idxval.rep == REP_z)
+        idxval.rep != REP_int)
      { exec_error(f, idx, "Index [%v] = %v is a bit too large",
                   vstr_obj, idx, vstr_val, &idxval);
      }
@@ -2260,6 +2485,8 @@ static void eval_int_subscript(int_subscript *x, exec_info *f)
          { idx = INT_REP_NRBITS - 1; }
        xval.v.i = ((xxv->v.i & (1UL << idx)) != 0);
      }
+   else if (xxv->rep == REP_wide)
+     { xval.v.i = wide_tstbit(xxv->v.wd->w, idx); }
    else if (xxv->rep == REP_z)
      { xval.v.i = mpz_tstbit(xxv->v.z->z, idx); }
    else
@@ -2270,9 +2497,9 @@ static void eval_int_subscript(int_subscript *x, exec_info *f)
  }
 
 static void assign_int_subscript(int_subscript *x, exec_info *f)
- { value_tp *xxv, idxval;
-   int neg = 0;
+ { value_tp *xxv;
    long idx, nr_bit, tmp;
+   ulong w[WIDE_REP_NRWORD];
    idx = eval_bit_index(x->idx, f);
    if (x->x->tp.tps->class == CLASS_integer_type)
      { nr_bit = integer_nr_bits(x->x->tp.tps, f);
@@ -2290,12 +2517,20 @@ static void assign_int_subscript(int_subscript *x, exec_info *f)
      }
    if (!xxv->rep)
      { xxv->rep = REP_int; xxv->v.i = 0; }
-   if (xxv->rep == REP_int && idxval.v.i < INT_REP_NRBITS-1)
+   if (xxv->rep == REP_int && idx < INT_REP_NRBITS-1)
      { if (f->val->v.i)
          { xxv->v.i = (xxv->v.i | (1UL << idx)); }
        else
          { xxv->v.i = (xxv->v.i & ~(1UL << idx)); }
      }
+   else if (idx < WIDE_REP_NRBITS && int_words(xxv, w))
+     { if (f->val->v.i)
+         { w[idx / INT_REP_NRBITS] |= 1UL << (idx % INT_REP_NRBITS); }
+       else
+         { w[idx / INT_REP_NRBITS] &= ~(1UL << (idx % INT_REP_NRBITS)); }
+       clear_value_tp(xxv, f);
+       int_set_words(xxv, w, f);
+     }
    else
      { if (xxv->rep == REP_int)
          { tmp = xxv->v.i;
@@ -2303,10 +2538,15 @@ static void assign_int_subscript(int_subscript *x, exec_info *f)
            xxv->v.z = new_z_value(f);
            mpz_set_si(xxv->v.z->z, tmp);
          }
+       else
+         { int_unwide(xxv, f);
+           unshare_z(xxv, f);
+         }
        if (f->val->v.i)
          { mpz_setbit(xxv->v.z->z, idx); }
        else
          { mpz_clrbit(xxv->v.z->z, idx); }
+       int_simplify(xxv, f);
      }
    range_check(x->x->tp.tps, xxv, f, x);
    RESET_FLAG(f->flags, EVAL_bit);
@@ -2317,7 +2557,7 @@ static void eval_int_subrange(int_subrange *x, exec_info *f)
    void *y;
    int rev = 0;
    long lidx, hidx, tmp, n, i, nr_bit;
-   mpz_t mask;
+   ulong w[WIDE_REP_NRWORD], xw[WIDE_REP_NRWORD];
    void (*cp)(value_tp *, value_tp *, exec_info *);
    lidx = eval_bit_index(x->l, f);
    hidx = eval_bit_index(x->h, f);
@@ -2356,20 +2596,26 @@ static void eval_int_subrange(int_subrange *x, exec_info *f)
      { xval.rep = REP_int;
        xval.v.i = (long)((((ulong)xxv->v.i) >> lidx) & ((1UL << n) - 1));
      }
+   else if (n <= WIDE_REP_NRBITS && int_words(xxv, xw))
+     { wide_extract(w, xw, lidx, n);
+       if (!IS_SET(x->x->flags, EXPR_lvalue))
+         { clear_value_tp(xxv, f); }
+       int_set_words(&xval, w, f);
+     }
    else
-     { if (xxv->rep == REP_z)
-         { cp(&xval, xxv, f); }
+     { if (xxv->rep != REP_int)
+         { cp(&xval, xxv, f);
+           int_unwide(&xval, f);
+         }
        else
          { xval.rep = REP_z;
            xval.v.z = new_z_value(f);
            mpz_set_si(xval.v.z->z, xxv->v.i);
          }
-       mpz_init_set_ui(mask, 1);
-       mpz_mul_2exp(mask, mask, n);
-       mpz_sub_ui(mask, mask, 1);
+       unshare_z(&xval, f);
        mpz_fdiv_q_2exp(xval.v.z->z, xval.v.z->z, lidx);
-       mpz_and(xval.v.z->z, xval.v.z->z, mask);
-       mpz_clear(mask);
+       mpz_fdiv_r_2exp(xval.v.z->z, xval.v.z->z, n);
+       int_simplify(&xval, f);
      }
    push_value(&xval, f);
  }
@@ -2392,6 +2638,27 @@ static void eval_array_subrange(array_subrange *x, exec_info *f)
      { xxv = reval_expr(x->x, f);
        if (!xxv->rep)
          { force_value(xxv, x->x, f); }
+       else if (xxv->rep == REP_packed)
+         { if (hidx - lidx >= ARRAY_REP_MAXSIZE)
+             { exec_error(f, x, "Implementation limit exceeded: Slice "
+                          "%v[%ld..%ld] is too large", vstr_obj, x->x,
+                          lidx, hidx);
+             }
+           if (IS_SET(x->flags, EXPR_ifrchk))
+             { f->err_obj = x;
+               strict_check_read_elem(xxv, f);
+               for (i = lidx; i <= hidx; i++)
+                 { strict_check_read(packed_elem(xxv, i, f), f); }
+             }
+           xval.rep = REP_array;
+           xval.v.l = xl = new_value_list(hidx - lidx + 1, f);
+           for (i = lidx, j = 0; i <= hidx; i++, j++)
+             { packed_get(&xl->vl[j], xxv, i, f); }
+           push_value(&xval, f);
+           return;
+         }
+       if (IS_SET(x->flags, EXPR_ifrchk))
+         { unshare_value(xxv, f); }
        l = xxv->v.l;
        if (IS_SET(x->flags, EXPR_ifrchk))
          { f->err_obj = x;
@@ -2426,7 +2693,9 @@ static void assign_int_subrange(int_subrange *x, exec_info *f)
  { value_tp *xxv;
    long lidx, hidx, n, i, tmp, nr_bit;
    int rev = 0;
-   mpz_t mask;
+   value_tp bits, low;
+   ulong xw[WIDE_REP_NRWORD], vw[WIDE_REP_NRWORD], w[WIDE_REP_NRWORD];
+   ulong mw[WIDE_REP_NRWORD];
    void *y;
    lidx = eval_bit_index(x->l, f);
    hidx = eval_bit_index(x->h, f);
@@ -2443,8 +2712,7 @@ static void assign_int_subrange(int_subrange *x, exec_info *f)
          }
        SET_FLAG(f->flags, EVAL_bit);
      }
-   if ((f->val->rep == REP_int && f->val->v.i < 0) ||
-       (f->val->rep == REP_z && mpz_sgn(f->val->v.z->z) < 0))
+   if (int_sgn(f->val) < 0)
      { exec_error(f, x, "You cannot assign a negative value (%v) to an "
                  "integer slice", vstr_val, f->val);
      }
@@ -2468,38 +2736,66 @@ static void assign_int_subrange(int_subrange *x, exec_info *f)
        xxv->v.i = xxv->v.i | (f->val->v.i << lidx);
        range_check(x->tp.tps, xxv, f, x);
      }
+   else if (hidx < WIDE_REP_NRBITS &&
+            int_words(xxv, xw) && int_words(f->val, vw))
+     { wide_extract(w, vw, 0, n);
+       if (wide_cmp(w, vw))
+         { exec_error(f, x,
+                     "Value %v is too large for integer slice %v[%d..%d]",
+                      vstr_val, f->val, vstr_obj, x, lidx, hidx);
+         }
+       /* xxv = (xxv with bits lidx..hidx cleared) | (val << lidx) */
+       for (i = 0; i < WIDE_REP_NRWORD; i++)
+         { w[i] = ~0UL; }
+       wide_extract(mw, w, 0, n);
+       wide_shift_left(w, mw, lidx);
+       wide_shift_left(mw, vw, lidx);
+       for (i = 0; i < WIDE_REP_NRWORD; i++)
+         { xw[i] = (xw[i] & ~w[i]) | mw[i]; }
+       clear_value_tp(xxv, f);
+       int_set_words(xxv, xw, f);
+       clear_value_tp(f->val, f);
+       range_check(x->tp.tps, xxv, f, x);
+     }
    else
-     { if (xxv->rep == REP_int)
+     { int_unwide(f->val, f);
+       if (xxv->rep == REP_int)
          { tmp = xxv->v.i;
            xxv->rep = REP_z;
            xxv->v.z = new_z_value(f);
            mpz_set_si(xxv->v.z->z, tmp);
          }
        else
-         { assert(xxv->v.z->refcnt == 1); }
-       mpz_init_set_ui(mask, 1);
-       mpz_mul_2exp(mask, mask, n);
-       mpz_sub_ui(mask, mask, 1);
+         { int_unwide(xxv, f);
+           unshare_z(xxv, f);
+         }
        if (f->val->rep == REP_int)
-         { tmp = mpz_cmp_si(mask, f->val->v.i); }
+         { tmp = n < INT_REP_NRBITS - 1 && f->val->v.i >> n; }
        else
-         { tmp = mpz_cmp(mask, f->val->v.z->z); }
-       if (tmp < 0)
+         { tmp = mpz_sizeinbase(f->val->v.z->z, 2) > n; }
+       if (tmp)
          { exec_error(f, x,
                      "Value %v is too large for integer slice %v[%d..%d]",
                       vstr_val, f->val, vstr_obj, x, lidx, hidx);
          }
-       mpz_mul_2exp(mask, mask, lidx);
-       mpz_com(mask, mask);
-       mpz_and(xxv->v.z->z, xxv->v.z->z, mask);
+       /* xxv = (xxv with bits lidx..hidx cleared) | (val << lidx) */
+       bits.rep = low.rep = REP_z;
+       bits.v.z = new_z_value(f);
+       low.v.z = new_z_value(f);
+       mpz_fdiv_r_2exp(low.v.z->z, xxv->v.z->z, lidx);
+       mpz_fdiv_q_2exp(xxv->v.z->z, xxv->v.z->z, lidx + n);
        if (f->val->rep == REP_int)
-         { mpz_set_ui(mask, f->val->v.i); }
+         { mpz_set_ui(bits.v.z->z, f->val->v.i); }
        else
-         { mpz_set(mask, f->val->v.z->z); }
-       mpz_mul_2exp(mask, mask, lidx);
-       mpz_ior(xxv->v.z->z, xxv->v.z->z, mask);
-       mpz_clear(mask);
+         { mpz_set(bits.v.z->z, f->val->v.z->z); }
+       mpz_mul_2exp(xxv->v.z->z, xxv->v.z->z, n);
+       mpz_ior(xxv->v.z->z, xxv->v.z->z, bits.v.z->z);
+       mpz_mul_2exp(xxv->v.z->z, xxv->v.z->z, lidx);
+       mpz_ior(xxv->v.z->z, xxv->v.z->z, low.v.z->z);
+       clear_value_tp(&bits, f);
+       clear_value_tp(&low, f);
        clear_value_tp(f->val, f);
+       int_simplify(xxv, f);
        range_check(x->tp.tps, xxv, f, x);
      }
    RESET_FLAG(f->flags, EVAL_bit);
@@ -2523,12 +2819,16 @@ static void assign_array_subrange(array_subrange *x, exec_info *f)
    xxv = reval_expr(x->x, f);
    if (!xxv->rep)
      { force_value(xxv, x->x, f); }
-   l = xxv->v.l;
+   unshare_value(xxv, f);
    if (IS_SET(x->flags, EXPR_ifrchk))
      { f->err_obj = x;
        strict_check_write_elem(xxv, f);
        for (i = lidx; i <= hidx; i++)
-         { strict_check_write(&l->vl[i], f); }
+         { if (xxv->rep == REP_packed)
+             { strict_check_write(packed_elem(xxv, i, f), f); }
+           else
+             { strict_check_write(&xxv->v.l->vl[i], f); }
+         }
      }
    l = f->val->v.l;
    n = hidx - lidx + 1;
@@ -2536,6 +2836,14 @@ static void assign_array_subrange(array_subrange *x, exec_info *f)
      { exec_error(f, x, "Assignment of %ld values to slice %v[%ld..%ld] "
                  "with %ld values", l->size, vstr_obj, x->x, lidx, hidx, n);
      }
+   if (xxv->rep == REP_packed)
+     { for (i = lidx, j = 0; i <= hidx && xxv->rep == REP_packed; i++, j++)
+         { packed_set(xxv, i, &l->vl[j], f); }
+       if (xxv->rep == REP_packed)
+         { clear_value_tp(f->val, f);
+           return;
+         }
+     }
    xl = xxv->v.l;
    if (l->refcnt == 1)
      { cp = copy_and_clear; }
@@ -2612,6 +2920,8 @@ static void *reval_field_of_record(field_of_record *x, exec_info *f)
    else if (v->rep == REP_union)
      { exec_error(f, x, "Use of conflicting decompositions"); }
    assert(v->rep == REP_record);
+   if (IS_SET(f->flags, EVAL_assign) || IS_SET(x->flags, EXPR_ifrchk))
+     { unshare_value(v, f); }
    if (IS_SET(x->flags, EXPR_ifrchk))
      { strict_check_elem(x->x, v, f); }
    return &v->v.l->vl[x->idx];
@@ -2630,6 +2940,7 @@ static void *connect_field_of_record(field_of_record *x, exec_info *f)
    else if (v->rep == REP_union)
      { exec_error(f, x, "Use of conflicting decompositions"); }
    assert(v->rep == REP_record);
+   unshare_value(v, f);
    return &v->v.l->vl[x->idx];
  }
 
@@ -2688,8 +2999,9 @@ static process_state *new_wu_process
    char *c;
    const str *nm;
    if (IS_SET(f->user->flags, USER_nohide))
-     { var_str_printf(&f->scratch, 0, "%s/%V/%s", f->meta_ps->nm, vstr_wire,
-                      &p->wprobe, f->meta_ps, dir? x->id : "default");
+     { var_str_printf(&f->scratch, 0, "%s/%V/%s", ps_name(f->meta_ps),
+                      vstr_wire, &p->wprobe, f->meta_ps,
+                      dir? x->id : "default");
        for (c = f->scratch.s; *c != 0; c++)
          { if (*c == '.') *c = '/'; }
        nm = make_str(f->scratch.s);
@@ -2882,27 +3194,279 @@ static void *connect_field_of_union(field_of_union *x, exec_info *f)
    return &vu->v;
  }
 
+#define CALL_FRAME_NRVAR 16 /* variables of a direct call kept on the stack */
+
+/* State of f that a function executed directly (see eval_call) must not
+   disturb; with a nested exec_info these fields would be separate.
+*/
+typedef struct call_state
+   { exec_flags flags;
+     ctrl_state *curr;
+     value_tp *val, pkv, *pk;
+     long pk_idx;
+     void *err_obj;
+     wire_expr *e;
+     guarded_cmnd *gc;
+     eval_stack *gcrv;
+     sem_context *gcxt, *gccxt;
+   } call_state;
+
+static void save_call_state(call_state *c, exec_info *f)
+ /* Save the state of f in c, and reset f for a direct function call */
+ { c->flags = f->flags;   c->curr = f->curr;      c->val = f->val;
+   c->pkv = f->pkv;       c->pk = f->pk;          c->pk_idx = f->pk_idx;
+   c->err_obj = f->err_obj;                       c->e = f->e;
+   c->gc = f->gc;         c->gcrv = f->gcrv;
+   c->gcxt = f->gcxt;     c->gccxt = f->gccxt;
+   f->pkv.rep = REP_none; f->pk = 0;              f->gc = 0;
+ }
+
+static void restore_call_state(call_state *c, exec_info *f)
+ /* Restore the state of f saved by save_call_state */
+ { clear_value_tp(&f->pkv, f);
+   f->flags = c->flags;   f->curr = c->curr;      f->val = c->val;
+   f->pkv = c->pkv;       f->pk = c->pk;          f->pk_idx = c->pk_idx;
+   f->err_obj = c->err_obj;                       f->e = c->e;
+   f->gc = c->gc;         f->gcrv = c->gcrv;
+   f->gcxt = c->gcxt;     f->gccxt = c->gccxt;
+ }
+
+/* With -memo, each function with DEF_seq gets a memo_cache holding the
+   results of its most recent calls, keyed by the parameter values.  The
+   cache is disabled when evaluating the function makes a call that is not
+   pure (a builtin such as random(), or a function that is not DEF_seq),
+   which is detected with f->nr_impure.
+*/
+#define MEMO_NR_BUCKET 1024 /* power of 2 */
+#define MEMO_MAXSIZE 4096 /* cached results per function */
+
+typedef struct memo_entry memo_entry;
+struct memo_entry
+   { memo_entry *next; /* hash chain */
+     memo_entry *newer, *older; /* LRU list */
+     ulong h;
+     value_tp ret;
+     value_tp arg[1]; /* actually: value_tp arg[nr_arg]; */
+   };
+
+typedef struct memo_cache
+   { function_def *d;
+     int nr_arg, off;
+     long size, hits, misses;
+     memo_entry *newest, *oldest;
+     memo_entry *bucket[MEMO_NR_BUCKET];
+   } memo_cache;
+
+static llist memo_caches = 0; /* llist(memo_cache) */
+
+static int hash_value(value_tp *v, ulong *h)
+ /* Add v to hash *h. Return 0 if v cannot be used as a key */
+ { long i;
+   mpz_t z;
+   switch (v->rep)
+     { case REP_bool: case REP_int:
+         *h = *h * 1000003 ^ (ulong)v->v.i;
+       return 1;
+       case REP_z:
+         *h = *h * 1000003 ^ mpz_get_ui(v->v.z->z) ^ mpz_size(v->v.z->z);
+       return 1;
+       case REP_wide: /* same hash as the equal REP_z */
+         mpz_init(z);
+         wide_get_z(z, v->v.wd->w);
+         *h = *h * 1000003 ^ mpz_get_ui(z) ^ mpz_size(z);
+         mpz_clear(z);
+       return 1;
+       case REP_symbol:
+         *h = *h * 1000003 ^ (ulong)v->v.s;
+       return 1;
+       case REP_array: case REP_record:
+         for (i = 0; i < v->v.l->size; i++)
+           { if (!hash_value(&v->v.l->vl[i], h)) return 0; }
+       return 1;
+       default:
+       return 0;
+     }
+ }
+
+static memo_cache *get_memo_cache(function_def *d)
+ { memo_cache *c;
+   if (!d->memo)
+     { NEW(c);
+       c->d = d;
+       c->nr_arg = llist_size(&d->pl);
+       c->off = 0;
+       c->size = c->hits = c->misses = 0;
+       c->newest = c->oldest = 0;
+       memset(c->bucket, 0, sizeof(c->bucket));
+       d->memo = c;
+       llist_append(&memo_caches, c);
+     }
+   return d->memo;
+ }
+
+static void memo_unlink(memo_cache *c, memo_entry *e)
+ /* remove e from the LRU list */
+ { if (e->newer) e->newer->older = e->older;
+   else c->newest = e->older;
+   if (e->older) e->older->newer = e->newer;
+   else c->oldest = e->newer;
+ }
+
+static void memo_link(memo_cache *c, memo_entry *e)
+ /* make e the most recently used entry */
+ { e->newer = 0;
+   e->older = c->newest;
+   if (c->newest) c->newest->newer = e;
+   else c->oldest = e;
+   c->newest = e;
+ }
+
+static void memo_free(memo_cache *c, memo_entry *e, exec_info *f)
+ /* Pre: e is not in the cache */
+ { int i;
+   for (i = 0; i < c->nr_arg; i++)
+     { clear_value_tp(&e->arg[i], f); }
+   clear_value_tp(&e->ret, f);
+   free(e);
+ }
+
+static memo_entry *memo_lookup
+(memo_cache *c, value_tp *var, call *x, exec_info *f)
+ /* Return the entry for the parameter values in var[], if present.
+    Otherwise, return a new entry (not yet in the cache) with a copy
+    of the parameter values, or 0 if they cannot be used as a key.
+ */
+ { memo_entry *e;
+   parameter *p;
+   llist mp;
+   ulong h = 0;
+   int i;
+   mp = x->d->pl;
+   while (!llist_is_empty(&mp))
+     { p = llist_head(&mp);
+       if (!hash_value(&var[p->d->var_idx], &h)) return 0;
+       mp = llist_alias_tail(&mp);
+     }
+   for (e = c->bucket[h & (MEMO_NR_BUCKET - 1)]; e; e = e->next)
+     { if (e->h != h) continue;
+       mp = x->d->pl;
+       i = 0;
+       while (!llist_is_empty(&mp))
+         { p = llist_head(&mp);
+           if (!equal_value(&e->arg[i], &var[p->d->var_idx], f, x)) break;
+           mp = llist_alias_tail(&mp);
+           i++;
+         }
+       if (i == c->nr_arg)
+         { c->hits++;
+           memo_unlink(c, e);
+           memo_link(c, e);
+           return e;
+         }
+     }
+   c->misses++;
+   e = malloc(sizeof(*e) + (c->nr_arg - 1) * sizeof(value_tp));
+   if (!e)
+     { error("Not enough memory"); }
+   e->h = h;
+   e->ret.rep = REP_none;
+   mp = x->d->pl;
+   i = 0;
+   while (!llist_is_empty(&mp))
+     { p = llist_head(&mp);
+       copy_value_tp(&e->arg[i], &var[p->d->var_idx], f);
+       mp = llist_alias_tail(&mp);
+       i++;
+     }
+   return e;
+ }
+
+static void memo_insert(memo_cache *c, memo_entry *e, exec_info *f)
+ /* Add new entry e to c, evicting the least recently used entry if full */
+ { memo_entry *old, **b;
+   if (c->size == MEMO_MAXSIZE)
+     { old = c->oldest;
+       memo_unlink(c, old);
+       b = &c->bucket[old->h & (MEMO_NR_BUCKET - 1)];
+       while (*b != old)
+         { b = &(*b)->next; }
+       *b = old->next;
+       memo_free(c, old, f);
+       c->size--;
+     }
+   b = &c->bucket[e->h & (MEMO_NR_BUCKET - 1)];
+   e->next = *b;
+   *b = e;
+   memo_link(c, e);
+   c->size++;
+ }
+
+extern void report_memo(user_info *U)
+ /* With -memo, report the hit rate of each function result cache */
+ { llist m;
+   memo_cache *c;
+   if (!IS_SET(U->flags, USER_memo)) return;
+   m = memo_caches;
+   while (!llist_is_empty(&m))
+     { c = llist_head(&m);
+       if (c->off)
+         { report(U, "(memo) %s: disabled (not pure)\n", c->d->id); }
+       else if (!c->hits && !c->misses)
+         { report(U, "(memo) %s: no cacheable calls\n", c->d->id); }
+       else
+         { report(U, "(memo) %s: %ld calls, %ld hits (%ld%%), %ld cached\n",
+                  c->d->id, c->hits + c->misses, c->hits,
+                  c->hits * 100 / (c->hits + c->misses), c->size);
+         }
+       m = llist_alias_tail(&m);
+     }
+ }
+
 static void eval_call(call *x, exec_info *f)
- /* used for function call */
+ /* used for function call.
+    A function with DEF_seq set is executed directly, in immediate mode,
+    with a ctrl_state on the C stack.  Otherwise a nested exec_info is
+    used to run the function body (this allows stepping through it).
+ */
  { exec_info sub;
-   ctrl_state *s;
+   call_state cs;
+   ctrl_state *s, frame;
    expr *a;
    parameter *p;
    llist ma, mp;
-   value_tp *var, xval, *argv = NO_INIT;
-   int i, argc = 0;
+   value_tp *var, xval, *argv = NO_INIT, vbuf[CALL_FRAME_NRVAR];
+   int i, argc = 0, direct;
+   long nr_impure;
+   memo_cache *mc;
+   memo_entry *me = 0;
    dbg_flags ps_flags = f->curr->ps->flags;
    if (IS_SET(x->d->flags, DEF_varargs))
      { exec_error(f, x, "Cannot evaluate procedure %s", x->id); }
-   exec_info_init_sub(&sub, f);
-   SET_IF_SET(sub.flags, f->flags, EXEC_instantiation);
-   s = new_ctrl_state(&sub);
+   direct = IS_SET(x->d->flags, DEF_seq) &&
+            !IS_SET(f->flags, EXEC_eval_only) &&
+            !IS_SET(ps_flags, DBG_step | DBG_trace);
+   if (direct)
+     { s = &frame;
+       memset(s, 0, sizeof(*s)); /* incl. act.time and call_flags */
+       s->act.cs = s;
+       llist_init(&s->seq);
+       s->stack = f->curr;
+       llist_init(&s->dep);
+     }
+   else
+     { exec_info_init_sub(&sub, f);
+       SET_IF_SET(sub.flags, f->flags, EXEC_instantiation);
+       s = new_ctrl_state(&sub);
+     }
    s->obj = (parse_obj*)x->d;
    s->nr_var = x->d->nr_var;
    s->ps = f->curr->ps;
    s->cxt = x->d->cxt;
    RESET_FLAG(f->curr->ps->flags, DBG_next);
-   NEW_ARRAY(s->var, s->nr_var);
+   if (direct && s->nr_var <= CALL_FRAME_NRVAR)
+     { s->var = vbuf; }
+   else
+     { NEW_ARRAY(s->var, s->nr_var); }
    var = s->var;
    for (i = 0; i < s->nr_var; i++)
      { var[i].rep = REP_none; }
@@ -2932,22 +3496,56 @@ static void eval_call(call *x, exec_info *f)
            ma = llist_alias_tail(&ma);
          }
      }
-   insert_sched(s, &sub);
-   exec_run(&sub);
-   if (x->d->ret) copy_and_clear(&xval, &var[x->d->ret->var_idx], f);
-   else xval.rep = REP_none;
+   if (direct && IS_SET(f->user->flags, USER_memo) && !argc)
+     { mc = get_memo_cache(x->d);
+       if (!mc->off)
+         { me = memo_lookup(mc, var, x, f); }
+     }
+   if (me && me->ret.rep)
+     { copy_value_tp(&var[x->d->ret->var_idx], &me->ret, f); }
+   else if (direct)
+     { nr_impure = f->nr_impure;
+       save_call_state(&cs, f);
+       f->curr = s;
+       exec_immediate(&x->d->b->dl, f);
+       exec_immediate(&x->d->b->sl, f);
+       restore_call_state(&cs, f);
+       if (me)
+         { if (f->nr_impure != nr_impure)
+             { mc->off = 1; }
+           else if (var[x->d->ret->var_idx].rep == REP_packed)
+             { unpack_value(&me->ret, &var[x->d->ret->var_idx], f); }
+           else
+             { copy_value_tp(&me->ret, &var[x->d->ret->var_idx], f); }
+           if (me->ret.rep)
+             { memo_insert(mc, me, f); }
+           else
+             { memo_free(mc, me, f); }
+         }
+     }
+   else
+     { f->nr_impure++;
+       insert_sched(s, &sub);
+       exec_run(&sub);
+     }
+   if (!x->d->ret) xval.rep = REP_none;
+   else if (var[x->d->ret->var_idx].rep == REP_packed)
+     { unpack_value(&xval, &var[x->d->ret->var_idx], f); }
+   else copy_and_clear(&xval, &var[x->d->ret->var_idx], f);
    SET_FLAG(f->curr->ps->flags, IS_SET(ps_flags, DBG_next));
    if (!xval.rep && x->d->ret)
      { exec_warning(f, x, "Function %s did not return a value", x->id); }
    for (i = 0; i < x->d->nr_var; i++)
      { clear_value_tp(&var[i], f); }
-   free(var);
+   if (var != vbuf)
+     { free(var); }
    if (argc)
      { for (i = 0; i < argc; i++)
          { clear_value_tp(&argv[i], f); }
        free(argv);
      }
-   exec_info_term(&sub);
+   if (!direct)
+     { exec_info_term(&sub); }
    push_value(&xval, f);   
  }
 
@@ -3017,6 +3615,8 @@ static int pop_call(call *x, exec_info *f)
        p = llist_head(&mp);
        if (p->par_sym == KW_res || p->par_sym == KW_valres)
          { pval = &var[p->d->var_idx];
+           if (pval->rep == REP_packed)
+             { unpack_value(pval, pval, f); }
            if (!pval->rep)
              { exec_warning(f, x, "Procedure %s did not assign result "
                             "parameter '%s'", x->id, p->d->id);
@@ -3060,6 +3660,7 @@ static void eval_token_expr(token_expr *x, exec_info *f)
                     xval.rep = REP_z;
                     xval.v.z = new_z_value(f);
                     mpz_set(xval.v.z->z, x->t.val.z);
+                    int_simplify(&xval, f);
                   }
        break;
        case TP_bool:
@@ -3102,7 +3703,10 @@ static void eval_var_ref(var_ref *x, exec_info *f)
  { value_tp xval, *val;
    assert(x->var_idx < f->curr->nr_var);
    val = &f->curr->var[x->var_idx];
-   alias_value_tp(&xval, val, f);
+   if (val->rep == REP_packed)
+     { packed_read(&xval, val, f); }
+   else
+     { alias_value_tp(&xval, val, f); }
    if (!xval.rep)
      { exec_warning(f, x, "Variable %s has no value", x->d->id); }
    push_value(&xval, f);
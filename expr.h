@@ -134,6 +134,9 @@ extern void port_to_array(value_tp *v, expr *x, exec_info *f);
 extern void default_value(value_tp *v, exec_info *f);
  /* Pre: v is union value */
 
+extern void report_memo(struct user_info *U);
+ /* With -memo, report the hit rate of each function result cache */
+
 extern void init_expr(void);
  /* call at startup */
 
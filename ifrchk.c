@@ -401,7 +401,7 @@ static strict_check_record *scr_access_bit(strict_check_record *r, int n)
 
 extern void strict_check_init(process_state *ps, exec_info *f)
  { NEW(ps->accesses);
-   hash_table_init(ps->accesses, 1, HASH_ptr_is_key, scr_delete);
+   hash_table_init(ps->accesses, 1, HASH_ptr_is_key | HASH_open, scr_delete);
  }
 
 extern void strict_check_term(process_state *ps, exec_info *f)
@@ -434,6 +434,30 @@ static int is_parent_frame(ctrl_state *a, ctrl_state *b, exec_info *f)
    return 0;
  }
 
+static long sub_nr_block(value_tp *v)
+ /* Elements of v are visited in blocks: the pages of a packed array,
+  * or the whole value_list otherwise.  Return the nr of blocks.
+  */
+ { if (v->rep == REP_packed) return v->v.k->nr_page;
+   return 1;
+ }
+
+static value_tp *sub_block(value_tp *v, long p, long *n)
+ /* Return the elements in block p of v (0 if there are none that can
+  * have been accessed), and set *n to their number.
+  */
+ { packed_value *k;
+   if (v->rep != REP_packed)
+     { *n = v->v.l->size;
+       return v->v.l->vl;
+     }
+   k = v->v.k;
+   if (k->nr_bit || !k->page[p]) return 0;
+   *n = k->size - (p << PACKED_PAGE_BITS);
+   if (*n > PACKED_PAGE_SIZE) *n = PACKED_PAGE_SIZE;
+   return (value_tp*)k->page[p];
+ }
+
 static void strict_check_read_real
 (strict_check_record *r, ctrl_state *frame, exec_info *f)
  { if (!IS_SET(r->flags, SCR_read_ok)
@@ -456,15 +480,19 @@ static void strict_check_read_sub
 (value_tp *v, ctrl_state *frame, hash_table *h, exec_info *f)
  { hash_entry *e;
    strict_check_record *r;
-   value_list *vl = v->v.l;
-   int i;
-   for (i = 0; i < vl->size; i++)
-     { e = hash_find(h, (char*)&vl->vl[i]);
-       if (!e) continue;
-       r = e->data.p;
-       strict_check_read_real(r, frame, f);
-       if (IS_SET(r->flags, SCR_sub_elem))
-         { strict_check_read_sub(&vl->vl[i], frame, h, f); }
+   value_tp *vl;
+   long i, p, n;
+   for (p = 0; p < sub_nr_block(v); p++)
+     { vl = sub_block(v, p, &n);
+       if (!vl) continue;
+       for (i = 0; i < n; i++)
+         { e = hash_find(h, (char*)&vl[i]);
+           if (!e) continue;
+           r = e->data.p;
+           strict_check_read_real(r, frame, f);
+           if (IS_SET(r->flags, SCR_sub_elem))
+             { strict_check_read_sub(&vl[i], frame, h, f); }
+         }
      }
  }
 
@@ -574,16 +602,20 @@ static void strict_check_write_sub
 (value_tp *v, ctrl_state *frame, hash_table *h, exec_info *f)
  { hash_entry *e;
    strict_check_record *r;
-   value_list *vl = v->v.l;
-   int i;
-   for (i = 0; i < vl->size; i++)
-     { e = hash_find(h, (char*)&vl->vl[i]);
-       if (!e) continue;
-       r = e->data.p;
-       strict_check_write_real(r, frame, f);
-       if (IS_SET(r->flags, SCR_sub_elem))
-         { strict_check_write_sub(&vl->vl[i], frame, h, f); }
-       hash_delete(h, (char*)&vl->vl[i]);
+   value_tp *vl;
+   long i, p, n;
+   for (p = 0; p < sub_nr_block(v); p++)
+     { vl = sub_block(v, p, &n);
+       if (!vl) continue;
+       for (i = 0; i < n; i++)
+         { e = hash_find(h, (char*)&vl[i]);
+           if (!e) continue;
+           r = e->data.p;
+           strict_check_write_real(r, frame, f);
+           if (IS_SET(r->flags, SCR_sub_elem))
+             { strict_check_write_sub(&vl[i], frame, h, f); }
+           hash_delete(h, (char*)&vl[i]);
+         }
      }
  }
 
@@ -676,15 +708,19 @@ extern void strict_check_write_bits(value_tp *v, int l, int h, exec_info *f)
 static void strict_check_delete_sub(value_tp *v, hash_table *h, exec_info *f)
  { hash_entry *e;
    strict_check_record *r;
-   value_list *vl = v->v.l;
-   int i;
-   for (i = 0; i < vl->size; i++)
-     { e = hash_find(h, (char*)&vl->vl[i]);
-       if (!e) continue;
-       r = e->data.p;
-       if (IS_SET(r->flags, SCR_sub_elem))
-         { strict_check_delete_sub(&vl->vl[i], h, f); }
-       hash_delete(h, (char*)&vl->vl[i]);
+   value_tp *vl;
+   long i, p, n;
+   for (p = 0; p < sub_nr_block(v); p++)
+     { vl = sub_block(v, p, &n);
+       if (!vl) continue;
+       for (i = 0; i < n; i++)
+         { e = hash_find(h, (char*)&vl[i]);
+           if (!e) continue;
+           r = e->data.p;
+           if (IS_SET(r->flags, SCR_sub_elem))
+             { strict_check_delete_sub(&vl[i], h, f); }
+           hash_delete(h, (char*)&vl[i]);
+         }
      }
  }
 
@@ -65,6 +65,7 @@
 #include "exec.h"
 #include "types.h"
 #include "parse.h"
+#include "ifrchk.h"
 #include <errno.h>
 
 #include <readline/readline.h>
@@ -104,10 +105,15 @@ extern void user_info_init(user_info *f)
    llist_init(&f->hprocs);
    llist_init(&f->ml);
    llist_init(&f->path);
+   llist_init(&f->levels);
    llist_init(&f->wait);
    hash_table_init(&f->brk_condition, 1, HASH_ptr_is_key,
                    (hash_func*)free_brk_cond);
    f->brk_condition.del_info = f;
+   hash_table_init(&f->instances, 1,
+                   HASH_const_keys | HASH_fixed_len_key | HASH_open, 0);
+   f->instances.key_len = sizeof(instance_name);
+   f->ps_skip = 0;
    f->cxt = 0;
    /* These are initialized at start of interaction: */
    f->global = f->focus = (void*)0xBAD;
@@ -192,30 +198,70 @@ static void eval_interact(value_tp *v, expr *e, ctrl_state *cs, user_info *f)
 
 extern int is_visible(process_state *ps)
  /* false if ps should be invisible (cannot be looked up by name) */
- { return ps->nm && ps->nm[1] != '/'; }
+ { return ps->in.parent || (ps->nm && ps->nm[1] != '/'); }
+
+extern process_state *find_child
+(user_info *f, process_state *prnt, const str *id)
+ /* Return the instance named id in prnt, or 0 if there is none */
+ { instance_name key;
+   hash_entry *e;
+   key.parent = prnt;
+   key.id = id;
+   e = hash_find(&f->instances, (char*)&key);
+   return e? e->data.p : 0;
+ }
+
+extern process_state *find_ancestor
+(user_info *f, const char *nm, const char **rest)
+ /* Pre: nm[0] == '/'
+    Return the closest existing instance that nm is a part of, and set
+    *rest to the remainder of nm ("" if that is the instance itself).
+ */
+ { process_state *ps = f->main, *c;
+   const str *id;
+   const char *p;
+   nm++;
+   while (ps && *nm)
+     { /* if ancestors were missing, an instance can have '/' in its id */
+       if ((id = find_str(nm)) && (c = find_child(f, ps, id)))
+         { ps = c; nm = ""; break; }
+       p = strchr(nm, '/');
+       if (!p) break;
+       var_str_slice_copy(&f->rep, 0, nm, p - nm);
+       var_str_slice_copy(&f->rep, p - nm, "", -1);
+       if (!(id = find_str(f->rep.s)) || !(c = find_child(f, ps, id))) break;
+       ps = c;
+       nm = p + 1;
+     }
+   *rest = nm;
+   return ps;
+ }
 
-static process_state *_find_instance(process_state *ps, const str *nm)
- { llist l;
-   int len;
-   process_state *ret;
-   if (!ps) return 0;
-   if (ps->nm == nm) return ps;
-   len = strlen(ps->nm);
-   if (len == 1) len = 0;
-   if (strncmp(ps->nm, nm, len) || nm[len] != '/') return 0;
-   for (l = ps->children; !llist_is_empty(&l); l = llist_alias_tail(&l))
-     { ret = _find_instance(llist_head(&l), nm);
-       if (ret) return ret;
+extern const char *ps_name(process_state *ps)
+ /* Return the full name of ps. For instances in the hierarchy, this is
+    only built (and kept) when it is first needed.
+ */
+ { const char *pnm;
+   char *s;
+   if (!ps->nm)
+     { pnm = ps->in.parent->in.parent? ps_name(ps->in.parent) : "";
+       NEW_ARRAY(s, strlen(pnm) + strlen(ps->in.id) + 2);
+       sprintf(s, "%s/%s", pnm, ps->in.id);
+       ps->nm = s;
      }
-   return 0;
+   return ps->nm;
  }
 
 extern process_state *find_instance(user_info *f, const str *nm, int must)
  /* Find the process instance for nm. If 'must' and not found, then a new
     instance is created.
  */
- { process_state *ps;
-   ps = _find_instance(f->main, nm);
+ { process_state *ps = 0;
+   const char *rest;
+   if (nm[0] == '/' && f->main)
+     { ps = find_ancestor(f, nm, &rest);
+       if (*rest) ps = 0;
+     }
    if (!ps && must)
      { ps = new_process_state(f->global, nm); }
    return ps;
@@ -260,7 +306,7 @@ static int cmnd_flag(user_info *f, dbg_flags flag, int set)
    process_state *ps;
    if (lex_have(f->L, TOK_instance))
      { nm = f->L->curr->t.val.s;
-       if (nm != f->curr->ps->nm)
+       if (strcmp(nm, ps_name(f->curr->ps)))
          { ps = find_instance(f, nm,
                               IS_SET(f->global->flags, EXEC_instantiation));
            if (!ps)
@@ -341,7 +387,7 @@ static int show_thread(action *a, user_info *f)
      { msg = "susp-perm"; }
    else
      { msg = "suspended"; }
-   report(f, "(%s) %s at %s[%d:%d]\n", msg, cs->ps->nm, cs->obj->src,
+   report(f, "(%s) %s at %s[%d:%d]\n", msg, ps_name(cs->ps), cs->obj->src,
           cs->obj->lnr, cs->obj->lpos);
    return 0;
  }
@@ -463,20 +509,26 @@ static void show_connections(process_state *ps, user_info *f)
    f->global->meta_ps = meta_ps;
  }
 
+static action *wire_expr_susp(wire_expr *e)
+ /* Return the thread suspended on e, or 0 if e is not a suspension */
+ { while (!IS_SET(e->flags, WIRE_action | WIRE_llist))
+     { e = e->u.dep; }
+   if ((e->flags & WIRE_action) == WIRE_ready)
+     { return e->u.rdy? e->u.rdy->rs->act : 0; }
+   if (IS_SET(e->flags, WIRE_hold | WIRE_llist)) return 0;
+   return e->u.act;
+ }
+
 static void __get_susp_threads(wire_value *w, hash_table *h, user_info *f)
- { llist l;
-   wire_expr *e;
+ { int i;
+   action *a;
    if (!IS_SET(w->flags, WIRE_has_dep)) return;
-   l = w->u.dep;
-   while (!llist_is_empty(&l))
-     { e = llist_head(&l);
-       l = llist_alias_tail(&l);
-       while (!IS_SET(e->flags, WIRE_action | WIRE_llist))
-         { e = e->u.dep; }
-       if (IS_SET(e->flags, WIRE_hold | WIRE_llist)) continue;
-       if (!IS_SET(e->u.act->flags, ACTION_sched) &&
-           e->u.act->cs->ps == f->ps && e->u.act != &f->global->curr->act)
-         { hash_insert(h, (char*)e->u.act, 0); }
+   for (i = w->u.dep.nr - 1; i >= 0; i--)
+     { a = wire_expr_susp(DEP_IDX(&w->u.dep, i));
+       if (!a) continue;
+       if (!IS_SET(a->flags, ACTION_sched) &&
+           a->cs->ps == f->ps && a != &f->global->curr->act)
+         { hash_insert(h, (char*)a, 0); }
      }
  }
 
@@ -541,12 +593,12 @@ static int _show_all_threads(process_state *ps, user_info *f)
    if (IS_SET(ps->flags, PROC_noexec)) return 0;
    if (!is_visible(ps)) return 0;
    if (ps->nr_susp == 0)
-     { report(f, "  %s: %d active threads", ps->nm, ps->nr_thread); }
+     { report(f, "  %s: %d active threads", ps_name(ps), ps->nr_thread); }
    else if (ps->nr_susp == ps->nr_thread)
-     { report(f, "  %s: %d suspended threads", ps->nm, ps->nr_susp); }
+     { report(f, "  %s: %d suspended threads", ps_name(ps), ps->nr_susp); }
    else
      { report(f, "  %s: %d active, %d suspended threads",
-              ps->nm, ps->nr_thread - ps->nr_susp, ps->nr_susp);
+              ps_name(ps), ps->nr_thread - ps->nr_susp, ps->nr_susp);
      }
    return 0;
  }
@@ -669,8 +721,8 @@ extern int cmnd_where(user_info *f)
          { class = cs->obj->class;
            if (is_visible(cs->ps) && (first || class == CLASS_call))
              { report(f, "%s at %s[%d:%d]\n\t%v\n",
-                      cs->ps->nm, cs->obj->src, cs->obj->lnr, cs->obj->lpos,
-                      vstr_stmt, cs->obj);
+                      ps_name(cs->ps), cs->obj->src, cs->obj->lnr,
+                      cs->obj->lpos, vstr_stmt, cs->obj);
                first = 0;
              }
            cs = cs->stack;
@@ -727,7 +779,8 @@ static int cmnd_up(user_info *f)
    set_view_level(f, f->view_pos + n);
    x = f->curr->obj;
    report(f, "(view) %s at %s[%d:%d]\n\t%v\n",
-             f->curr->ps->nm, x->src, x->lnr, x->lpos, vstr_stmt, x);
+             ps_name(f->curr->ps), x->src, x->lnr, x->lpos,
+             vstr_stmt, x);
    return 1;
  }
 
@@ -744,7 +797,8 @@ static int cmnd_down(user_info *f)
    set_view_level(f, f->view_pos - n);
    x = f->curr->obj;
    report(f, "(view) %s at %s[%d:%d]\n\t%v\n",
-             f->curr->ps->nm, x->src, x->lnr, x->lpos, vstr_stmt, x);
+             ps_name(f->curr->ps), x->src, x->lnr, x->lpos,
+             vstr_stmt, x);
    return 1;
  }
 
@@ -799,7 +853,7 @@ static int set_focus(user_info *f)
    process_state *ps;
    if (!lex_have(f->L, TOK_instance)) return 0;
    nm = f->L->curr->t.val.s;
-   if (nm == f->curr->ps->nm) return 0;
+   if (!strcmp(nm, ps_name(f->curr->ps))) return 0;
    ps = find_instance(f, nm, 0);
    if (!ps || ps->nr_thread == 0)
      { report(f, "  No such process instance: %s\n", nm);
@@ -823,7 +877,8 @@ static int cmnd_view(user_info *f)
    if (!set_focus(f))
      { x = f->curr->obj;
        report(f, "(view) %s at %s[%d:%d]\n\t%v\n",
-              f->curr->ps->nm, x->src, x->lnr, x->lpos, vstr_stmt, x);
+              ps_name(f->curr->ps), x->src, x->lnr, x->lpos,
+              vstr_stmt, x);
      }
    return 1;
  }
@@ -838,8 +893,8 @@ static process_state *_deadlock_find(process_state *ps, exec_info *f);
 static process_state *__deadlock_find
 (value_tp *v, process_state *ps, exec_info *f)
  { int i;
-   llist l;
-   wire_expr *e;
+   dep_list *d;
+   action *a;
    process_state *r;
    switch (v->rep)
      { case REP_array: case REP_record:
@@ -854,15 +909,10 @@ static process_state *__deadlock_find
          if (!v->v.p->p) return 0; /* TODO: maybe return ps? */
          if (!IS_SET(v->v.p->wprobe.flags, WIRE_has_dep)) return 0;
          /* TODO: remove most of the below */
-         l = v->v.p->wprobe.u.dep;
-         while (!llist_is_empty(&l))
-           { e = llist_head(&l);
-             l = llist_alias_tail(&l);
-             while (!IS_SET(e->flags, WIRE_action | WIRE_llist))
-               { e = e->u.dep; }
-             if (IS_SET(e->flags, WIRE_hold | WIRE_llist))
-               { continue; }
-             if (e->u.act->cs->ps == ps)
+         d = &v->v.p->wprobe.u.dep;
+         for (i = d->nr - 1; i >= 0; i--)
+           { a = wire_expr_susp(DEP_IDX(d, i));
+             if (a && a->cs->ps == ps)
                { return _deadlock_find(v->v.p->p->wprobe.wps, f); }
            }
        return 0;
@@ -1330,9 +1380,27 @@ static int wire_cmnd(wire_func_tp *F, const str *cmd, user_info *f)
 #define SET_WIRE_CMD(C) static int cmnd_ ## C(user_info *f) \
                          { return wire_cmnd(wire_ ## C, #C, f); }
 
+static int wire_is_pruned(wire_value *w, user_info *f)
+ /* If w was pruned (see -prune), say so and return 1 */
+ { if (!IS_SET(w->flags, WIRE_pruned)) return 0;
+   report(f, "  Wire has been pruned (it is constant or unobservable)\n");
+   return 1;
+ }
+
+static int wire_is_bypassed(wire_value *w, user_info *f)
+ /* If w is no longer driven (see wu_procs_bypass), say so and return 1 */
+ { if (!IS_SET(w->flags, WIRE_bypassed)) return 0;
+   report(f, "  Wire is not driven "
+             "(its conversion processes have been bypassed)\n");
+   return 1;
+ }
+
 /* wire_func_tp */
 static void wire_watch(wire_value *w, user_info *f)
- { SET_FLAG(w->flags, WIRE_watch); }
+ { if (wire_is_pruned(w, f)) return; /* its value is no longer kept */
+   if (wire_is_bypassed(w, f)) return; /* it will not change */
+   SET_FLAG(w->flags, WIRE_watch);
+ }
 
 SET_WIRE_CMD(watch)
 
@@ -1399,13 +1467,14 @@ static void print_pr
  }
 
 static void _wire_fanout
-(wire_value *orig, llist dep, hash_table *emap, llist *prs, user_info *f)
- { wire_expr *e;
+(wire_value *orig, dep_list *dep, hash_table *emap, llist *prs, user_info *f)
+ { int i;
+   wire_expr *e;
    wire_value *w;
    void *prev;
    hash_entry *q;
-   while (!llist_is_empty(&dep))
-     { e = llist_head(&dep);
+   for (i = dep->nr - 1; i >= 0; i--)
+     { e = DEP_IDX(dep, i);
        prev = orig;
        while (1)
          { if (hash_insert(emap, (char*)e, &q))
@@ -1425,14 +1494,15 @@ static void _wire_fanout
              { llist_prepend(prs, e); }
            else if (IS_ALLSET(e->flags, WIRE_x))
              { w = e->u.hold;
-               if (IS_SET(w->flags, WIRE_has_dep) && !llist_is_empty(&w->u.dep))
-                 { _wire_fanout(orig, w->u.dep, emap, prs, f); }
+               if (IS_SET(w->flags, WIRE_has_dep) && w->u.dep.nr)
+                 { _wire_fanout(orig, &w->u.dep, emap, prs, f); }
              }
+           else if ((e->flags & WIRE_action) == WIRE_ready)
+             { if (e->u.rdy && e->u.rdy->rs->act) llist_prepend(prs, e); }
            else
              { assert(!"Unsupported fanout type"); }
            break;
          }
-       dep = llist_alias_tail(&dep);
      }
  }
 
@@ -1443,21 +1513,24 @@ static void wire_fanout(wire_value *w, user_info *f)
    ctrl_state *cs;
    llist m, prs; /* Unique list of pr expressions */
    print_info g;
-   if (!IS_SET(w->flags, WIRE_has_dep) || llist_is_empty(&w->u.dep))
+   wire_is_pruned(w, f);
+   if (!IS_SET(w->flags, WIRE_has_dep) || !w->u.dep.nr)
      { report(f, "  Wire has no fanouts\n");
        return;
      }
-   hash_table_init(&emap, 1, HASH_ptr_is_key, (hash_func*)emap_delete);
+   hash_table_init(&emap, 1, HASH_ptr_is_key | HASH_open,
+                   (hash_func*)emap_delete);
    llist_init(&prs);
-   _wire_fanout(w, w->u.dep, &emap, &prs, f);
+   _wire_fanout(w, &w->u.dep, &emap, &prs, f);
    report(f, "%d fanouts:\n", llist_size(&prs));
    g.s = &f->scratch; g.flags = 0; g.f = stdout;
    while (!llist_is_empty(&prs))
      { pr = llist_idx_extract(&prs, 0);
-       if (IS_SET(pr->flags, WIRE_susp)) /* fanout to HSE */
-         { cs = pr->u.act->cs;
+       if (IS_SET(pr->flags, WIRE_susp) ||
+           (pr->flags & WIRE_action) == WIRE_ready) /* fanout to HSE */
+         { cs = wire_expr_susp(pr)->cs;
            if (is_visible(cs->ps))
-             { report(f, "fanout to %s at %s[%d:%d]:\n\t%v\n", cs->ps->nm,
+             { report(f, "fanout to %s at %s[%d:%d]:\n\t%v\n", ps_name(cs->ps),
                       cs->obj->src, cs->obj->lnr, cs->obj->lpos,
                       vstr_stmt, cs->obj);
              }
@@ -1474,7 +1547,8 @@ static void wire_fanout(wire_value *w, user_info *f)
                       IS_SET(pr->flags, WIRE_pu)? '+' : '-');
              }
            else
-             { report(f, "%s -> %s:%V%c", f->scratch.s, pr->u.act->cs->ps->nm,
+             { report(f, "%s -> %s:%V%c", f->scratch.s,
+                      ps_name(pr->u.act->cs->ps),
                       vstr_wire, pr->u.act->target, pr->u.act->cs->ps,
                       IS_SET(pr->flags, WIRE_pu)? '+' : '-');
              }
@@ -1491,7 +1565,7 @@ static void _wire_fanin
    void *prev;
    hash_entry *q;
    wire_expr *e, *ee;
-   llist l;
+   dep_list *d;
    switch (v->rep)
      { case REP_array: case REP_record:
          for (i = 0; i < v->v.l->size; i++)
@@ -1499,16 +1573,16 @@ static void _wire_fanin
        return;
        case REP_wwire: case REP_rwire:
          if (!IS_SET(v->v.w->flags, WIRE_has_dep)) return;
-         l = v->v.w->u.dep;
+         d = &v->v.w->u.dep;
        break;
        default:
        return;
      }
-   while (!llist_is_empty(&l))
-     { e = ee = llist_head(&l);
-       l = llist_alias_tail(&l);
+   for (i = d->nr - 1; i >= 0; i--)
+     { e = ee = DEP_IDX(d, i);
        while (!IS_SET(e->flags, WIRE_action))
          { e = e->u.dep; }
+       if ((e->flags & WIRE_action) == WIRE_ready) continue;
        if (e->u.act->target.w != w) continue;
        if (IS_SET(e->flags, WIRE_pu))
          { assert(!*pu || *pu == e); *pu = e; }
@@ -1543,6 +1617,9 @@ static void wire_fanin(wire_value *w, user_info *f)
        return;
      }
    ps = w->wframe->cs->ps;
+   if (IS_SET(w->wframe->flags, ACTION_is_pr) && wire_is_pruned(w, f))
+     { return; }
+   if (wire_is_bypassed(w, f)) return;
    if (!IS_SET(w->wframe->flags, ACTION_is_pr))
      { if (ps == &const_frame_ps)
          { report(f, "  Wire is connected to rail '%s'\n",
@@ -1557,14 +1634,15 @@ static void wire_fanin(wire_value *w, user_info *f)
          }
        return;
      }
-   hash_table_init(&emap, 1, HASH_ptr_is_key, (hash_func*)emap_delete);
+   hash_table_init(&emap, 1, HASH_ptr_is_key | HASH_open,
+                   (hash_func*)emap_delete);
    for (i = 0; i < ps->nr_var; i++)
      { _wire_fanin(&ps->var[i], &emap, &pu, &pd, w); }
    nr = 0; if (pu) nr++; if (pd) nr++;
    if (ps == f->curr->ps)
      { report(f, "  %d fanins:", nr); }
    else
-     { report(f, "  %d fanins in %s:", nr, ps->nm); }
+     { report(f, "  %d fanins in %s:", nr, ps_name(ps)); }
    g.s = &f->scratch; g.flags = 0; g.f = stdout; g.pos = 0;
    if (pu)
      { print_pr(pu, &emap, ps, &g);
@@ -1586,6 +1664,7 @@ static void wire_critical(wire_value *w, user_info *f)
  { crit_node *c;
    hash_entry *q;
    mpz_t time;
+   if (wire_is_bypassed(w, f)) return;
    if (!IS_SET(f->flags, USER_critical))
      { report(f, "  Use the -critical command line option to enable"
                  " critical cycle checking");
@@ -1710,7 +1789,7 @@ static wire_value *new_wpp(process_state *ps)
    NEW(w);
    w->flags = WIRE_has_dep | WIRE_is_probe;
    w->refcnt = 1;
-   llist_init(&w->u.dep);
+   dep_list_init(&w->u.dep);
    w->wps = ps;
    return w;
  }
@@ -1718,7 +1797,7 @@ static wire_value *new_wpp(process_state *ps)
 static void setup_wprobe(wire_value *w)
  { assert(!IS_SET(w->flags, WIRE_has_dep));
    SET_FLAG(w->flags, WIRE_has_dep | PORT_multiprobe);
-   llist_init(&w->u.dep);
+   dep_list_init(&w->u.dep);
  }
 
 static void add_we_action
@@ -1737,7 +1816,7 @@ static void add_we_action
 
 static void add_wire(wire_value *w, wire_expr *e, exec_info *f)
  { e->refcnt++; e->valcnt++;
-   llist_prepend(&w->u.dep, e);
+   dep_list_add(&w->u.dep, e);
  }
 
 static void attach_port(value_tp *pval, exec_info *f);
@@ -1753,41 +1832,41 @@ static void create_multiport(port_value *q, port_value *p, exec_info *f)
    decomp = IS_SET(xpp->flags, PORT_deadwu);
    if (IS_SET(xpp->flags, PORT_multiprobe))
      { yp = p->wpp; ypp = pp->wpp;
-       assert(llist_size(&xpp->u.dep) == 1);
-       assert(llist_size(&ypp->u.dep) == 1);
-       exx = llist_head(&xpp->u.dep);
-       eyy = llist_head(&ypp->u.dep);
+       assert(xpp->u.dep.nr == 1);
+       assert(ypp->u.dep.nr == 1);
+       exx = DEP_IDX(&xpp->u.dep, 0);
+       eyy = DEP_IDX(&ypp->u.dep, 0);
        if (!decomp)
-         { assert(llist_size(&xp->u.dep) == 1);
-           assert(llist_size(&yp->u.dep) == 1);
-           ex = llist_head(&xp->u.dep);
-           ey = llist_head(&yp->u.dep);
+         { assert(xp->u.dep.nr == 1);
+           assert(yp->u.dep.nr == 1);
+           ex = DEP_IDX(&xp->u.dep, 0);
+           ey = DEP_IDX(&yp->u.dep, 0);
          }
        else
          { ex = llist_head(&eyy->u.ldep);
            assert((ex->flags & WIRE_action) == WIRE_xu);
            z = PORT_FROM_WPROBE(ex->u.hold);
-           assert(llist_size(&z->wprobe.u.dep) == 1);
-           ex = llist_head(&z->wprobe.u.dep);
-           assert(llist_size(&z->wpp->u.dep) == 1);
-           ey = llist_head(&z->wpp->u.dep);
+           assert(z->wprobe.u.dep.nr == 1);
+           ex = DEP_IDX(&z->wprobe.u.dep, 0);
+           assert(z->wpp->u.dep.nr == 1);
+           ey = DEP_IDX(&z->wpp->u.dep, 0);
          }
      }
    else if (IS_SET(xp->flags, PORT_multiprobe))
      { assert(decomp);
        setup_wprobe(xpp);
        yp = p->wpp; ypp = pp->wpp;
-       assert(llist_size(&xp->u.dep) == 1);
-       assert(llist_size(&yp->u.dep) == 1);
-       ex = llist_head(&xp->u.dep);
-       ey = llist_head(&yp->u.dep);
+       assert(xp->u.dep.nr == 1);
+       assert(yp->u.dep.nr == 1);
+       ex = DEP_IDX(&xp->u.dep, 0);
+       ey = DEP_IDX(&yp->u.dep, 0);
        exx = llist_head(&ey->u.ldep);
        assert((exx->flags & WIRE_action) == WIRE_xu);
        z = PORT_FROM_WPROBE(exx->u.hold);
-       assert(llist_size(&z->wprobe.u.dep) == 1);
-       exx = llist_head(&z->wprobe.u.dep);
-       assert(llist_size(&z->wpp->u.dep) == 1);
-       eyy = llist_head(&z->wpp->u.dep);
+       assert(z->wprobe.u.dep.nr == 1);
+       exx = DEP_IDX(&z->wprobe.u.dep, 0);
+       assert(z->wpp->u.dep.nr == 1);
+       eyy = DEP_IDX(&z->wpp->u.dep, 0);
        etmp = new_wire_expr(f);
        etmp->flags = WIRE_val_dir | WIRE_value | WIRE_trigger | WIRE_llist;
        llist_prepend(&etmp->u.ldep, ey);
@@ -1797,7 +1876,7 @@ static void create_multiport(port_value *q, port_value *p, exec_info *f)
        etmp = new_wire_expr(f);
        etmp->refcnt = etmp->valcnt = 2;
        etmp->flags = WIRE_val_dir | WIRE_value | WIRE_trigger | WIRE_llist;
-       llist_prepend(&ypp->u.dep, etmp);
+       dep_list_add(&ypp->u.dep, etmp);
        llist_prepend(&eyy->u.ldep, etmp);
        eyy = etmp;
        add_wire(xpp, exx, f);
@@ -1919,7 +1998,7 @@ static wire_value *hse_multiwire_fix(wire_value *w, exec_info *f)
    wnew->flags = WIRE_has_writer | WIRE_has_dep;
    SET_IF_SET(wnew->flags, w->flags, WIRE_value);
    wnew->refcnt = 1;
-   llist_init(&wnew->u.dep);
+   dep_list_init(&wnew->u.dep);
    wnew->wframe = w->wframe;
    w->refcnt++;
    cs = w->wframe->cs;
@@ -1933,7 +2012,7 @@ static void create_multiwire(value_tp *wv, exec_info *f)
  { wire_expr *e;
    wire_value *wref, *w;
    action *act;
-   llist l;
+   int i;
    w = wv->v.w;
    act = w->wframe;
    if (!IS_SET(act->flags, ACTION_dummy))
@@ -1949,7 +2028,7 @@ static void create_multiwire(value_tp *wv, exec_info *f)
            wref->flags = WIRE_has_writer | WIRE_has_dep | WIRE_virtual;
            SET_IF_SET(wref->flags, w->flags, WIRE_value);
            wref->refcnt = 2;
-           llist_init(&wref->u.dep);
+           dep_list_init(&wref->u.dep);
            wref->wframe = act;
            act->target.w = wref;
          }
@@ -1965,9 +2044,8 @@ static void create_multiwire(value_tp *wv, exec_info *f)
      }
    else
      { wref = llist_head(&act->fanin);
-       l = wref->u.dep;
-       do { e = llist_head(&l);
-            l = llist_alias_tail(&l);
+       i = wref->u.dep.nr;
+       do { e = DEP_IDX(&wref->u.dep, --i);
           } while (!IS_SET(e->flags, WIRE_trigger));
      }
    NEW(wref);
@@ -1975,7 +2053,7 @@ static void create_multiwire(value_tp *wv, exec_info *f)
    SET_IF_SET(wref->flags, w->flags, WIRE_value);
    wref->refcnt = 2;
    wref->wframe = &f->user->ps->cs->act;
-   llist_init(&wref->u.dep);
+   dep_list_init(&wref->u.dep);
    llist_prepend(&act->fanin, wref);
    add_wire(wref, e, f);
    wv->v.w = wref;
@@ -2412,7 +2490,8 @@ extern void interact_report(exec_info *f)
    else if (IS_SET(f->curr->ps->flags, DBG_step))
      { rep = cmnd = "step"; }
    report(f->user, "(%s) %s at %s[%d:%d]\n\t%v\n", reason,
-          f->curr->ps->nm, x->src, x->lnr, x->lpos, vstr_stmt, x);
+          ps_name(f->curr->ps), x->src, x->lnr, x->lpos,
+          vstr_stmt, x);
    RESET_FLAG(f->curr->ps->flags, DBG_step|DBG_next);
    if (!IS_SET(f->user->flags, USER_batch) || exec_interrupted)
      { interact(f, make_str(cmnd)); }
@@ -2494,7 +2573,7 @@ static void ctrl_c(int sig)
 static int process_not_started(process_state *ps, exec_info *f)
  /* if ps has not started, warn appropriately. Always return 0 */
  { if (!ps->nr_thread)
-     { report(f->user, "(warning) no process instance %s\n", ps->nm); }
+     { report(f->user, "(warning) no process instance %s\n", ps_name(ps)); }
    return 0;
  }
 
@@ -2547,6 +2626,33 @@ extern void interact_chp(exec_info *f)
      }
  }
 
+/* llist_func */
+static int drop_process_debug_info(process_state *ps, exec_info *f)
+ /* ps can only execute statements if it has a chp or hse body; otherwise
+    its table for interference checking is never used.  The statements of
+    the meta, prs and delay bodies have all been executed by now.  Their
+    declarations stay, as they are used to print wire names.
+    Always return 0.
+ */
+ { process_def *p = ps->p;
+   if (!ps->b || (ps->b->class != CLASS_chp_body &&
+                  ps->b->class != CLASS_hse_body))
+     { strict_check_term(ps, f); }
+   if (p->mb) parse_free_stmts(&p->mb->sl);
+   if (p->pb) parse_free_stmts(&p->pb->sl);
+   if (p->db) parse_free_stmts(&p->db->sl);
+   return 0;
+ }
+
+extern void drop_debug_info(exec_info *f)
+ /* Pre: prepare_chp(f) has been called, and there is no debug prompt.
+    Free the data that is only needed to interact with the user.
+ */
+ { procs_apply_all(f->user, (llist_func*)drop_process_debug_info, f);
+   hash_table_free(&f->user->instances); /* instances are found by name */
+   drop_sem_contexts(); /* for parsing expressions at the prompt */
+ }
+
 /********** search path ******************************************************/
 
 extern void set_default_path(user_info *f)
@@ -2592,6 +2698,135 @@ extern void show_path(user_info *f)
  }
 
 
+/********** abstraction levels ***********************************************/
+
+/* A line of the level file applies to each instance whose name matches its
+   pattern, and to all descendants of such instances.  In a pattern, '*'
+   matches any sequence of characters other than '/', so "/" selects every
+   instance, and "/cpu/alu[*]" selects all ALUs of /cpu.  If several lines
+   apply, the last one wins.  A process without the selected body uses its
+   usual body; a meta body is still needed to reach a lower level below it.
+*/
+
+/* The name of an instance is matched while walking from its outermost
+   ancestor down, so that instance_level() does not need ps_name().
+*/
+typedef struct level_name level_name;
+struct level_name
+   { process_state **a; /* a[n]; a[0] is the outermost ancestor */
+     int n, i; /* a[i] is the current instance */
+     const char *s; /* rest of the name of a[i] */
+     int sep; /* the '/' before s is still to come */
+   };
+
+static process_state **level_anc = 0; /* buffer for level_name.a */
+static int level_anc_max = 0;
+
+static int level_chr(level_name *c)
+ /* Return the current character of the name, or 0 at its end */
+ { while (!c->sep && !*c->s && c->i + 1 < c->n)
+     { c->i++;
+       c->s = c->a[c->i]->in.id;
+       c->sep = 1;
+     }
+   return c->sep? '/' : *c->s;
+ }
+
+static void level_adv(level_name *c)
+ /* Pre: level_chr(c) != 0 */
+ { if (c->sep) c->sep = 0;
+   else c->s++;
+ }
+
+static int level_match(const char *p, level_name c)
+ /* true if pattern p matches the name c, or an ancestor of c */
+ { int ch;
+   while (*p && *p != '*')
+     { if (*p != level_chr(&c)) return 0;
+       p++; level_adv(&c);
+     }
+   if (!*p)
+     { ch = level_chr(&c);
+       return !ch || ch == '/';
+     }
+   p++;
+   while (1)
+     { if (level_match(p, c)) return 1;
+       ch = level_chr(&c);
+       if (!ch || ch == '/') return 0;
+       level_adv(&c);
+     }
+ }
+
+extern void read_levels(user_info *f, const char *nm)
+ /* Read the abstraction level file nm. Each line has an instance name
+    pattern followed by one of meta, chp, hse or prs; '#' starts a comment.
+ */
+ { FILE *fin;
+   char line[1024], pat[1024], lvl[16], *c;
+   int lnr = 0, pos;
+   level_entry *e;
+   FOPEN(fin, nm, "r");
+   while (fgets(line, sizeof(line), fin))
+     { lnr++;
+       if ((c = strchr(line, '#'))) *c = 0;
+       if (sscanf(line, " %1023s %15s %n", pat, lvl, &pos) < 2)
+         { if (sscanf(line, " %1s", lvl) < 1) continue; /* empty line */
+           error("%s[%d]: expected an instance name and a level", nm, lnr);
+         }
+       if (line[pos])
+         { error("%s[%d]: unexpected text after the level", nm, lnr); }
+       if (pat[0] != '/')
+         { error("%s[%d]: instance names must start with a '/': %s",
+                 nm, lnr, pat);
+         }
+       NEW(e);
+       if (!strcmp(lvl, "meta")) e->lvl = LEVEL_meta;
+       else if (!strcmp(lvl, "chp")) e->lvl = LEVEL_chp;
+       else if (!strcmp(lvl, "hse")) e->lvl = LEVEL_hse;
+       else if (!strcmp(lvl, "prs")) e->lvl = LEVEL_prs;
+       else
+         { error("%s[%d]: unknown level %s (use meta, chp, hse or prs)",
+                 nm, lnr, lvl);
+         }
+       pos = strlen(pat);
+       while (pos > 0 && pat[pos-1] == '/')
+         { pat[--pos] = 0; }
+       e->pat = strdup(pat);
+       llist_prepend(&f->levels, e);
+     }
+   fclose(fin);
+ }
+
+extern body_level instance_level(user_info *f, process_state *ps)
+ /* Return the level that the level file selects for ps, or LEVEL_default */
+ { llist m;
+   level_entry *e;
+   level_name c;
+   process_state *a;
+   if (llist_is_empty(&f->levels) || !is_visible(ps)) return LEVEL_default;
+   c.n = 1;
+   for (a = ps; a->in.parent; a = a->in.parent)
+     { c.n++; }
+   if (c.n > level_anc_max)
+     { level_anc_max = c.n;
+       REALLOC_ARRAY(level_anc, level_anc_max);
+     }
+   c.a = level_anc;
+   c.i = c.n;
+   for (a = ps; a; a = a->in.parent)
+     { c.a[--c.i] = a; }
+   /* the outermost ancestor is the root, or has its full name already */
+   c.s = strcmp(c.a[0]->nm, "/")? c.a[0]->nm : "";
+   c.sep = 0;
+   for (m = f->levels; !llist_is_empty(&m); m = llist_alias_tail(&m))
+     { e = llist_head(&m);
+       if (level_match(e->pat, c)) return e->lvl;
+     }
+   return LEVEL_default;
+ }
+
+
 /********** readline/startup *************************************************/
 
 static char *command_generator(const char *text, int state)
@@ -2609,9 +2844,9 @@ static process_state *best_parent(process_state *ps, const char *nm)
  { llist l;
    int len;
    process_state *ret;
-   len = strlen(ps->nm);
+   len = strlen(ps_name(ps));
    if (len == 1) len = 0;
-   if (strncmp(ps->nm, nm, len) || nm[len] != '/') return 0;
+   if (strncmp(ps_name(ps), nm, len) || nm[len] != '/') return 0;
    for (l = ps->children; !llist_is_empty(&l); l = llist_alias_tail(&l))
      { ret = best_parent(llist_head(&l), nm);
        if (ret) return ret;
@@ -2638,16 +2873,16 @@ static char *instance_generator(const char *text, int state)
      { procs = llist_alias_tail(&procs); }
    while (!llist_is_empty(&procs))
      { ps = llist_head(&procs);
-       if (!strncmp(ps->nm, text, len))
+       if (!strncmp(ps_name(ps), text, len))
          { last_ps = ps;
            count++;
-           return no_dbg_strdup(ps->nm);
+           return no_dbg_strdup(ps_name(ps));
          }
        procs = llist_alias_tail(&procs);
      }
    if (count == 1 && !llist_is_empty(&last_ps->children))
      /* Do not add a space after an instance name with children */
-     { asprintf(&c, "%s/", last_ps->nm);
+     { asprintf(&c, "%s/", ps_name(last_ps));
        count = 2;
        return c;
      }
@@ -59,6 +59,17 @@ struct brk_cond
      llist e_alloc; /* list to be freed when e is freed */
    };
 
+typedef enum body_level
+   { LEVEL_default = 0, /* usual choice of body, see sched_instance_real() */
+     LEVEL_meta, LEVEL_chp, LEVEL_hse, LEVEL_prs
+   } body_level;
+
+typedef struct level_entry level_entry;
+struct level_entry
+   { char *pat; /* instance name pattern, without a trailing '/' */
+     body_level lvl;
+   };
+
 FLAGS(user_flags)
    { FIRST_FLAG(USER_batch), /* non-interactive operation */
      NEXT_FLAG(USER_started), /* has execution proper started? */
@@ -69,8 +80,12 @@ FLAGS(user_flags)
      NEXT_FLAG(USER_debug), /* Evaluating from the debug prompt */
      NEXT_FLAG(USER_random), /* use random timing */
      NEXT_FLAG(USER_nohide), /* do not hide wired decomposition processes */
+     NEXT_FLAG(USER_keepwu), /* never bypass wired decomposition processes */
      NEXT_FLAG(USER_critical), /* track critical cycles */
-     NEXT_FLAG(USER_clear) /* make brkp() clear, not set, breakpoints */
+     NEXT_FLAG(USER_clear), /* make brkp() clear, not set, breakpoints */
+     NEXT_FLAG(USER_memo), /* cache results of sequential functions */
+     NEXT_FLAG(USER_prune), /* remove unobservable and constant prs */
+     NEXT_FLAG(USER_lean) /* drop debug-only data before chp execution */
    };
 
 typedef struct user_info user_info;
@@ -82,12 +97,15 @@ struct user_info
      llist old_L; /* llist(lex_tp*) stack of command files */
      llist cmds; /* commands to pre-execute */
      process_state *main; /* The root instance */
+     hash_table instances; /* instance_name -> process_state */
+     int ps_skip; /* an instance was created before its parent */
      llist hprocs; /* llist(process_state*); hidden processes */
      int brk_lnr, brk_lpos; /* requested breakpoint */
      const char *brk_src; /* requested breakpoint module name */
      hash_table brk_condition; /* conditions on breakpoints */
      llist ml; /* llist(module_def) */
      llist path; /* llist(char*); search path for modules */
+     llist levels; /* llist(level_entry*); last line of level file first */
      exec_info *global; /* currently used by exec_run() */
      exec_info *focus; /* top-level of focus process */
      ctrl_state *focus_top; /* top-level of focus process */
@@ -126,6 +144,16 @@ extern void reset_path(user_info *f);
 extern void show_path(user_info *f);
  /* print search path */
 
+/********** abstraction levels ***********************************************/
+
+extern void read_levels(user_info *f, const char *nm);
+ /* Read the abstraction level file nm. Each line has an instance name
+    pattern followed by one of meta, chp, hse or prs; '#' starts a comment.
+ */
+
+extern body_level instance_level(user_info *f, process_state *ps);
+ /* Return the level that the level file selects for ps, or LEVEL_default */
+
 /*****************************************************************************/
 
 extern void report(user_info *f, const char *fmt, ...);
@@ -150,6 +178,11 @@ extern void interact_instantiate(exec_info *f);
 extern void prepare_chp(exec_info *f);
  /* Prepare chp execution phase */
 
+extern void drop_debug_info(exec_info *f);
+ /* Pre: prepare_chp(f) has been called, and there is no debug prompt.
+    Free the data that is only needed to interact with the user.
+ */
+
 extern void show_perm_threads(exec_info *g, user_info *f);
  /* Print all threads */
 
@@ -175,6 +208,22 @@ extern process_state *find_instance(user_info *f, const str *nm, int must);
 extern int is_visible(process_state *ps);
  /* false if ps should be invisible (cannot be looked up by name) */
 
+extern process_state *find_child
+(user_info *f, process_state *prnt, const str *id);
+ /* Return the instance named id in prnt, or 0 if there is none */
+
+extern process_state *find_ancestor
+(user_info *f, const char *nm, const char **rest);
+ /* Pre: nm[0] == '/'
+    Return the closest existing instance that nm is a part of, and set
+    *rest to the remainder of nm ("" if that is the instance itself).
+ */
+
+extern const char *ps_name(process_state *ps);
+ /* Return the full name of ps. For instances in the hierarchy, this is
+    only built (and kept) when it is first needed.
+ */
+
 extern process_def *find_routine
  (module_def *md, const str *id, user_info *f, int only);
  /* Find the routine with the specified id. If 'only', only search in md.
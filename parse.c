@@ -133,6 +133,120 @@ extern llist parse_delay_cleanup(lex_tp *L)
    return l;
  }
 
+/* Statements that are only executed during instantiation can be freed
+   once instantiation is done.  collect_stmts() finds the objects of such
+   statements: the statements and their expressions, but not the
+   declarations, types and definitions that they refer to.  H is used to
+   find each object only once.
+*/
+
+static void collect_stmt(void *x, hash_table *H, llist *l);
+
+static void collect_stmts(llist m, hash_table *H, llist *l)
+ { while (!llist_is_empty(&m))
+     { collect_stmt(llist_head(&m), H, l);
+       m = llist_alias_tail(&m);
+     }
+ }
+
+#define OBJ_COLLECT(X,C,F) \
+  if (((parse_obj*)X)->class==CLASS_ ## C) collect_stmt(((C*)X)->F, H, l)
+
+#define OBJ_COLLECT_LLIST(X,C,F) \
+  if (((parse_obj*)X)->class==CLASS_ ## C) collect_stmts(((C*)X)->F, H, l)
+
+static void collect_stmt(void *x, hash_table *H, llist *l)
+ { obj_class *base;
+   if (!x) return;
+   base = BASE_CLASS(((parse_obj*)x)->class);
+   if (base != CLASS_statement && base != CLASS_expr) return;
+   if (hash_insert(H, x, 0)) return;
+   llist_prepend(l, x);
+   OBJ_COLLECT(x, rep_expr, r.l);
+   OBJ_COLLECT(x, rep_expr, r.h);
+   OBJ_COLLECT(x, rep_expr, v);
+   OBJ_COLLECT(x, binary_expr, l);
+   OBJ_COLLECT(x, binary_expr, r);
+   OBJ_COLLECT(x, prefix_expr, r);
+   OBJ_COLLECT(x, probe, r);
+   OBJ_COLLECT_LLIST(x, value_probe, p);
+   OBJ_COLLECT(x, value_probe, b);
+   OBJ_COLLECT(x, array_subscript, x);
+   OBJ_COLLECT(x, array_subscript, idx);
+   OBJ_COLLECT(x, int_subscript, x);
+   OBJ_COLLECT(x, int_subscript, idx);
+   OBJ_COLLECT(x, int_port_subscript, x);
+   OBJ_COLLECT(x, int_port_subscript, idx);
+   OBJ_COLLECT(x, array_subrange, x);
+   OBJ_COLLECT(x, array_subrange, l);
+   OBJ_COLLECT(x, array_subrange, h);
+   OBJ_COLLECT(x, int_subrange, x);
+   OBJ_COLLECT(x, int_subrange, l);
+   OBJ_COLLECT(x, int_subrange, h);
+   OBJ_COLLECT(x, field_of_record, x);
+   OBJ_COLLECT(x, field_of_process, x);
+   OBJ_COLLECT(x, field_of_union, x);
+   OBJ_COLLECT_LLIST(x, array_constructor, l);
+   OBJ_COLLECT_LLIST(x, record_constructor, l);
+   OBJ_COLLECT_LLIST(x, call, a);
+   OBJ_COLLECT(x, implicit_array, x);
+   OBJ_COLLECT(x, wire_ref, x);
+   OBJ_COLLECT(x, property_ref, node);
+   OBJ_COLLECT(x, const_expr, x);
+   OBJ_COLLECT_LLIST(x, parallel_stmt, l);
+   OBJ_COLLECT_LLIST(x, compound_stmt, l);
+   OBJ_COLLECT(x, rep_stmt, r.l);
+   OBJ_COLLECT(x, rep_stmt, r.h);
+   OBJ_COLLECT_LLIST(x, rep_stmt, sl);
+   OBJ_COLLECT(x, assignment, v);
+   OBJ_COLLECT(x, assignment, e);
+   OBJ_COLLECT(x, bool_set_stmt, v);
+   OBJ_COLLECT(x, guarded_cmnd, g);
+   OBJ_COLLECT_LLIST(x, guarded_cmnd, l);
+   OBJ_COLLECT_LLIST(x, loop_stmt, gl);
+   OBJ_COLLECT_LLIST(x, loop_stmt, sl);
+   OBJ_COLLECT_LLIST(x, select_stmt, gl);
+   OBJ_COLLECT(x, select_stmt, w);
+   OBJ_COLLECT(x, communication, p);
+   OBJ_COLLECT(x, communication, e);
+   OBJ_COLLECT(x, meta_binding, x);
+   OBJ_COLLECT_LLIST(x, meta_binding, a);
+   OBJ_COLLECT(x, instance_stmt, mb);
+   OBJ_COLLECT(x, connection, a);
+   OBJ_COLLECT(x, connection, b);
+   OBJ_COLLECT(x, wired_connection, a);
+   OBJ_COLLECT(x, wired_connection, b);
+   OBJ_COLLECT(x, const_wired_connection, a);
+   OBJ_COLLECT(x, const_wired_connection, b);
+   OBJ_COLLECT(x, production_rule, g);
+   OBJ_COLLECT(x, production_rule, v);
+   OBJ_COLLECT(x, production_rule, delay);
+   OBJ_COLLECT(x, transition, v);
+   OBJ_COLLECT_LLIST(x, delay_hold, l);
+   OBJ_COLLECT(x, delay_hold, c);
+   OBJ_COLLECT(x, delay_hold, n);
+   OBJ_COLLECT(x, property_stmt, node);
+   OBJ_COLLECT(x, property_stmt, v);
+ }
+
+#undef OBJ_COLLECT
+#undef OBJ_COLLECT_LLIST
+
+extern void parse_free_stmts(llist *l)
+ /* Free the statements of l, with their expressions, and empty l.
+    Declarations, types and definitions are not freed.
+    Only use this when the statements will never be used again.
+ */
+ { hash_table H;
+   llist m;
+   llist_init(&m);
+   hash_table_init(&H, 1, HASH_ptr_is_key, 0);
+   collect_stmts(*l, &H, &m);
+   hash_table_free(&H);
+   llist_free(l, 0, 0);
+   llist_free(&m, parse_cleanup_aux, 0);
+ }
+
 INLINE_STATIC void free_parse(lex_tp *L, void *x)
  { if (!L->err_jmp) free_obj(x); }
 
@@ -378,6 +492,7 @@ static void parse_rep_common(rep_common *r, lex_tp *L)
    r->l = parse_expr(L);
    lex_must_be(L, SYM_dots);
    r->h = parse_expr(L);
+   r->lo = r->n = 0;
    lex_must_be(L, ':');
  }
 
@@ -1503,6 +1618,10 @@ static void *parse_process_definition(lex_tp *L)
      }
    if (!x->mb && !x->cb && !x->hb && !x->pb)
      { lex_error(L, "Expected a process body"); }
+   if (lex_have_next(L, KW_builtin))
+     { if (!x->cb) lex_error(L, "A builtin process needs a chp body");
+       SET_FLAG(x->flags, DEF_builtin);
+     }
    return x;
  }
 
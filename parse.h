@@ -70,4 +70,10 @@ extern void parse_cleanup_delayed(llist *l);
 extern llist parse_delay_cleanup(lex_tp *L);
  /* Pre: L->alloc_list has been initialized */
 
+extern void parse_free_stmts(llist *l);
+ /* Free the statements of l, with their expressions, and empty l.
+    Declarations, types and definitions are not freed.
+    Only use this when the statements will never be used again.
+ */
+
 #endif /* PARSE_H */
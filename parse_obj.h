@@ -95,6 +95,10 @@ FLAGS(parse_obj_flags)
      NEXT_FLAG(DEF_varargs), /* variable nr args for routine */
      NEXT_FLAG(DBG_break), /* breakpoint, for statements */
      NEXT_FLAG(DBG_break_cond), /* breakpoint with conditions */
+     NEXT_FLAG(STMT_ready), /* all guards are probes; see ready_set */
+     NEXT_FLAG(DEF_seq), /* function body is sequential, without
+                            communication; see eval_call */
+     NEXT_FLAG(TYPE_bounds), /* integer_type lo, hi are valid */
      EXPR_nocexpr = EXPR_unconst | EXPR_cparam | EXPR_rep,
                                 /* all const_expr disqualifiers */
      EXPR_all_const = EXPR_nocexpr | EXPR_meta,
@@ -168,6 +172,7 @@ typedef struct rep_common rep_common;
 struct rep_common
    { const str *id;
      expr *l, *h;
+     long lo, n; /* if n > 0, bounds are fixed: lo .. lo + n - 1 */
    };
 
 CLASS(rep_expr)
@@ -491,6 +496,7 @@ CLASS(generic_type)
 CLASS(integer_type)
    { TYPE_SPEC_OBJ;
      expr *l, *h;
+     long lo, hi; /* constant bounds, if TYPE_bounds; see range_check */
    };
 
 CLASS_2(field_def) /* not a type_spec */
@@ -641,6 +647,7 @@ CLASS_2(function_def) /* also for procedure_def */
      int nr_var; /* assigned by sem() */
      void *parent; /* function_def, process_def, or module_def */
      struct sem_context *cxt;
+     struct memo_cache *memo; /* with -memo, cached results; see eval_call */
    };
 
 CLASS_2(process_def)
@@ -659,6 +666,7 @@ CLASS_2(process_def)
      prs_body *pb;
      delay_body *db;
      property_body *ppb;
+     void *nb; /* if DEF_builtin, native implementation of cb */
    };
 
 /********** modules **********************************************************/
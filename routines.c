@@ -131,19 +131,18 @@ static void print_process_def(process_def *x, print_info *f)
    print_string(")\n\t(", f);
    print_obj_list(&x->pl, f, "; ");
    print_string(")\n", f);
+   if (x->mb) print_obj(x->mb, f);
+   if (x->cb) print_obj(x->cb, f);
+   if (x->hb) print_obj(x->hb, f);
+   if (x->pb) print_obj(x->pb, f);
    if (IS_SET(x->flags, DEF_builtin))
      { print_string("BUILTIN", f); }
-   else
-     { if (x->mb) print_obj(x->mb, f);
-       if (x->cb) print_obj(x->cb, f);
-       if (x->hb) print_obj(x->hb, f);
-       if (x->pb) print_obj(x->pb, f);
-     }
  }
 
 /********** semantic analysis ************************************************/
 
 static void get_builtin_func(function_def *x, sem_info *f);
+static void get_builtin_proc(process_def *x, sem_info *f);
 
 static void *sem_function_def(function_def *x, sem_info *f)
  { sem_flags flags;
@@ -175,7 +174,8 @@ static void *sem_function_def(function_def *x, sem_info *f)
        if (IS_SET(x->flags, DEF_builtin))
          { get_builtin_func(x, f); }
        else
-         { x->b = sem(x->b, f);
+         { if (x->ret) SET_FLAG(x->flags, DEF_seq); /* see sem_not_seq() */
+           x->b = sem(x->b, f);
            x->b = sem(x->b, f);
          }
      }
@@ -249,6 +249,8 @@ static void *sem_process_def(process_def *x, sem_info *f)
        if (x->db) x->db = sem_process_body(x, x->db, f);
        if (x->ppb) /* No declarations - No extra scope level; */
          { x->ppb = sem(x->ppb, f); x->ppb = sem(x->ppb, f); }
+       if (IS_SET(x->flags, DEF_builtin))
+         { get_builtin_proc(x, f); }
      }
    else
      { sem_list(&x->ml, f);
@@ -537,7 +539,7 @@ static void sched_instance_all(value_tp *v, exec_info *f)
              { mp = llist_idx(&ps->p->ml, i);
                exec_error(f, f->curr->ps->p,
                       "Instance %s has unknown meta parameter %s",
-                      ps->nm, mp->id);
+                      ps_name(ps), mp->id);
              }
          }
        l = ps->p->pl;
@@ -545,7 +547,7 @@ static void sched_instance_all(value_tp *v, exec_info *f)
        while (!llist_is_empty(&l))
          { d = llist_head(&l);
            var_str_printf(&f->scratch, 0, "In process %s, %%s %s",
-                          ps->nm, d->id);
+                          ps_name(ps), d->id);
            check_new_ports(&ps->var[d->var_idx], &d->tp, f);
            l = llist_alias_tail(&l);
          }
@@ -561,6 +563,8 @@ static int exec_process_def(process_def *x, exec_info *f)
    llist l;
    var_decl *d;
    chp_body *b; /* or meta_body, ... */
+   if (IS_SET(f->curr->ps->flags, PROC_native))
+     { return ((exec_builtin_proc*)x->nb)(f->curr->ps, f); }
    assert(f->curr->ps->nr_thread == 1);
    b = f->curr->ps->b;
    assert(b);
@@ -592,7 +596,7 @@ static int pop_process_def(process_def *x, exec_info *f)
        while (!llist_is_empty(&m))
          { d = llist_head(&m);
            var_str_printf(&f->scratch, 0, "In process %s, %%s %s",
-                          ps->nm, d->id);
+                          ps_name(ps), d->id);
            f->curr->i = d->flags;
            check_old_ports(&f->curr->var[d->var_idx], &d->tp, f);
            m = llist_alias_tail(&m);
@@ -602,6 +606,7 @@ static int pop_process_def(process_def *x, exec_info *f)
    ps->nr_thread--;
    assert(!ps->nr_thread);
    ps->nr_thread = -2;
+   free_ready_sets(ps, f); /* no thread will use them again */
    ps->refcnt--;
    free_process_state(ps, f);
    return EXEC_next;
@@ -647,6 +652,43 @@ static void get_builtin_func(function_def *x, sem_info *f)
    SET_FLAG(x->flags, DEF_builtin);
  }
 
+typedef struct builtin_proc_info
+   { const str *id;
+     exec_builtin_proc *f;
+     process_def *d;
+   } builtin_proc_info;
+
+static llist builtin_procs; /* llist(builtin_proc_info) */
+
+extern void set_builtin_proc(const char *nm, exec_builtin_proc *f)
+ /* set nm as name of native process implementation f */
+ { builtin_proc_info *b;
+   NEW(b);
+   b->id = make_str(nm);
+   b->f = f;
+   b->d = 0;
+   llist_prepend(&builtin_procs, b);
+ }
+
+/* llist_func */
+static int builtin_proc_eq(builtin_proc_info *b, const str *id)
+ /* true if b has name id */
+ { return b->id == id; }
+
+static void get_builtin_proc(process_def *x, sem_info *f)
+ /* set x to point to the native implementation identified by x->id */
+ { builtin_proc_info *b;
+   b = llist_find(&builtin_procs, (llist_func*)builtin_proc_eq, x->id);
+   if (!b)
+     { sem_error(f, x, "There is no builtin process %s", x->id); }
+   if (b->d)
+     { sem_error(f, x, "Builtin process %s was already defined at %s[%d:%d]",
+                    b->id, b->d->src, b->d->lnr, b->d->lpos);
+     }
+   x->nb = (void*)b->f;
+   b->d = x;
+ }
+
 extern value_tp *get_call_arg(function_def *x, int i, exec_info *f)
  /* Pre: a call of x is being executed.
     Return a pointer to argument value i (starting from 0) of x. This
@@ -720,7 +762,7 @@ static void exec_builtin_print(function_def *y, exec_info *f)
    call *x;
    x = (call*)f->curr->stack->obj;
    assert(x->class == CLASS_call);
-   pos += var_str_printf(&f->scratch, pos, "%s> ", f->curr->ps->nm);
+   pos += var_str_printf(&f->scratch, pos, "%s> ", ps_name(f->curr->ps));
    bif_print_argv(&x->a, 0, f, pos);
    fprintf(f->user->user_stdout, "%s", f->scratch.s);
  }
@@ -756,7 +798,7 @@ static void exec_builtin_show(function_def *y, exec_info *f)
    x = (call*)f->curr->stack->obj;
    assert(x->class == CLASS_call);
    pos += var_str_printf(&f->scratch, pos,  "%s> %s[%d:%d] \t",
-                        f->curr->ps->nm, x->src, x->lnr, x->lpos);
+                        ps_name(f->curr->ps), x->src, x->lnr, x->lpos);
    m = x->a; i = 0;
    if (f->curr->argc > 1)
      { pos += var_str_printf(&f->scratch, pos, "\n\t"); }
@@ -808,6 +850,7 @@ static void exec_builtin_random(function_def *x, exec_info *f)
    assert(x->ret);
    rval = &f->curr->var[x->ret->var_idx];
    xval = get_call_arg(x, 0, f);
+   int_unwide(xval, f);
    if (xval->rep == REP_int)
      { if (xval->v.i <= 0)
          { exec_error(f, x, "random() requires a positive integer argument"); }
@@ -59,6 +59,9 @@ extern void init_routines(void);
 extern void set_builtin_func(const char *nm, exec_builtin_func *f);
  /* set nm as name of builtin function f */
 
+extern void set_builtin_proc(const char *nm, exec_builtin_proc *f);
+ /* set nm as name of native implementation f of a BUILTIN process */
+
 extern value_tp *get_call_arg(function_def *x, int i, exec_info *f);
  /* Pre: a call of x is being executed.
     Return a pointer to argument value i (starting from 0) of x. This
@@ -154,6 +154,13 @@ extern void sem_rep_common(rep_common *x, sem_info *f)
      { sem_error(f, x->h, "Upper bound of replicator range is not constant."); }
  }
 
+extern void sem_not_seq(sem_info *f)
+ /* The current statement is not plain sequential code (see DEF_seq) */
+ { function_def *d = f->curr_routine;
+   if (d && d->class == CLASS_function_def)
+     { RESET_FLAG(d->flags, DEF_seq); }
+ }
+
 extern void sem_error(sem_info *f, void *obj, const char *fmt, ...)
  /* print error msg for parse_obj and exit */
  { va_list a;
@@ -193,6 +200,8 @@ extern void sem_warning(void *obj, const char *fmt, ...)
    FIX THIS COMMENT
 */
 
+static llist sem_cxts = 0; /* llist(sem_context); levels with a name table */
+
 extern void enter_level(void *owner, sem_context **cxt, sem_info *f)
  /* Start a nested scope level */
  { sem_info *tmp;
@@ -205,6 +214,7 @@ extern void enter_level(void *owner, sem_context **cxt, sem_info *f)
        f->cxt->parent = tmp->cxt;
        NEW(f->cxt->H);
        hash_table_init(f->cxt->H, 1, HASH_ptr_is_key, 0);
+       llist_prepend(&sem_cxts, f->cxt);
        *cxt = f->cxt;
      }
    else
@@ -225,6 +235,7 @@ extern void enter_body(void *owner, sem_context **cxt, sem_info *f)
        f->cxt->parent = tmp->cxt;
        NEW(f->cxt->H);
        hash_table_init(f->cxt->H, 1, HASH_ptr_is_key, 0);
+       llist_prepend(&sem_cxts, f->cxt);
        *cxt = f->cxt;
      }
    else
@@ -265,6 +276,28 @@ extern void leave_level(sem_info *f)
  }
 
 
+/* hash_func */
+static int free_id_info(hash_entry *q, void *dummy)
+ { id_info *d = q->data.p;
+   if (IS_SET(d->flags, SEM_conflict))
+     { llist_free(&d->u.l, 0, 0); }
+   free(d);
+   return 0;
+ }
+
+extern void drop_sem_contexts(void)
+ /* Free the name tables of all scope levels.  Only use this when no more
+    semantic analysis will be done, i.e., when there is no debug prompt.
+    The sem_contexts themselves remain, but can no longer be searched.
+ */
+ { sem_context *cxt;
+   while (!llist_is_empty(&sem_cxts))
+     { cxt = llist_idx_extract(&sem_cxts, 0);
+       hash_apply(cxt->H, free_id_info, 0);
+       hash_table_free(cxt->H);
+     }
+ }
+
 /********** declarations *****************************************************/
 
 extern void declare_id(sem_info *f, const str *id, void *x)
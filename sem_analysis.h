@@ -152,6 +152,9 @@ extern void sem_stmt_list(llist *l, sem_info *f);
 extern void sem_rep_common(rep_common *x, sem_info *f);
  /* Apply semantic analysis to the common elements of a rep_expr/rep_stmt */
 
+extern void sem_not_seq(sem_info *f);
+ /* The current statement is not plain sequential code (see DEF_seq) */
+
 /********** scope ************************************************************/
 
 extern void enter_level(void *owner, sem_context **cxt, sem_info *f);
@@ -169,6 +172,12 @@ extern void enter_sublevel
 extern void leave_level(sem_info *f);
  /* Leave the current scope level */
 
+extern void drop_sem_contexts(void);
+ /* Free the name tables of all scope levels.  Only use this when no more
+    semantic analysis will be done, i.e., when there is no debug prompt.
+    The sem_contexts themselves remain, but can no longer be searched.
+ */
+
 /********** declarations *****************************************************/
 
 extern void declare_id(sem_info *f, const str *id, void *x);
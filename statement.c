@@ -58,6 +58,7 @@
 #include "exec.h"
 #include "expr.h"
 #include "interact.h"
+#include "routines.h"
 
 /********** printing *********************************************************/
 
@@ -274,7 +275,8 @@ extern void sem_stmt_list(llist *l, sem_info *f)
  }
 
 static void *sem_parallel_stmt(parallel_stmt *x, sem_info *f)
- { sem_stmt_list(&x->l, f);
+ { sem_not_seq(f);
+   sem_stmt_list(&x->l, f);
    return x;
  }
 
@@ -290,6 +292,8 @@ static void *sem_rep_stmt(rep_stmt *x, sem_info *f)
        return x;
      }
    sem_rep_common(&x->r, f);
+   if (x->rep_sym == ',')
+     { sem_not_seq(f); }
    enter_sublevel(x, x->r.id, &x->cxt, f);
    sem_stmt_list(&x->sl, f);
    leave_level(f);
@@ -346,11 +350,125 @@ static void *sem_guarded_cmnd(guarded_cmnd *x, sem_info *f)
    return x;
  }
 
+static int ready_index(expr *x, llist *reps)
+ /* true if the value of x only depends on the replicators in reps */
+ { rep_var_ref *rv = (rep_var_ref*)x;
+   if (x->class == CLASS_const_expr || x->class == CLASS_const_ref ||
+       x->class == CLASS_meta_ref || x->class == CLASS_token_expr)
+     { return 1; }
+   else if (x->class == CLASS_rep_var_ref)
+     { return rv->re? !!llist_find(reps, 0, rv->re)
+                    : !!llist_find(reps, 0, rv->rs);
+     }
+   else if (x->class == CLASS_binary_expr)
+     { return ready_index(((binary_expr*)x)->l, reps) &&
+              ready_index(((binary_expr*)x)->r, reps);
+     }
+   else if (x->class == CLASS_prefix_expr)
+     { return ready_index(((prefix_expr*)x)->r, reps); }
+   return 0;
+ }
+
+static int ready_port(expr *x, llist *reps)
+ /* true if x is a port or wire of the process, selected by ready_index
+  * indices.
+  */
+ { if (x->class == CLASS_var_ref)
+     { return IS_SET(x->flags, EXPR_port | EXPR_wire) &&
+              !IS_SET(x->flags, EXPR_port_ext);
+     }
+   else if (x->class == CLASS_array_subscript)
+     { return ready_port(((array_subscript*)x)->x, reps) &&
+              ready_index(((array_subscript*)x)->idx, reps);
+     }
+   else if (x->class == CLASS_field_of_record)
+     { return ready_port(((field_of_record*)x)->x, reps); }
+   return 0;
+ }
+
+static int ready_wire_expr(expr *x, llist *reps)
+ /* true if x is a boolean expression of ready_port wires, as accepted
+  * by make_wire_expr.
+  */
+ { binary_expr *be = (binary_expr*)x;
+   rep_expr *re = (rep_expr*)x;
+   token_tp sym;
+   int r;
+   if (!IS_SET(x->flags, EXPR_unconst))
+     { return ready_index(x, reps); }
+   else if (x->class == CLASS_wire_ref)
+     { return ready_port(((wire_ref*)x)->x, reps); }
+   else if (x->class == CLASS_prefix_expr)
+     { return ((prefix_expr*)x)->op_sym == '~' &&
+              ready_wire_expr(((prefix_expr*)x)->r, reps);
+     }
+   else if (x->class != CLASS_binary_expr && x->class != CLASS_rep_expr)
+     { return 0; }
+   sym = (x->class == CLASS_binary_expr)? be->op_sym : re->rep_sym;
+   if (sym != '&' && sym != '|' && sym != KW_xor && sym != SYM_neq &&
+       sym != '=')
+     { return 0; }
+   if (x->class == CLASS_binary_expr)
+     { return ready_wire_expr(be->l, reps) && ready_wire_expr(be->r, reps); }
+   if (!ready_index(re->r.l, reps) || !ready_index(re->r.h, reps))
+     { return 0; }
+   llist_prepend(reps, re);
+   r = ready_wire_expr(re->v, reps);
+   llist_idx_extract(reps, 0);
+   return r;
+ }
+
+static int ready_guard_expr(expr *g, llist *reps)
+ /* true if g is a probe of a ready_port, or a ready_wire_expr */
+ { if (g->class == CLASS_probe)
+     { return IS_A_PORT(((probe*)g)->r) &&
+              ready_port(((probe*)g)->r, reps);
+     }
+   return IS_SET(g->flags, EXPR_unconst) && ready_wire_expr(g, reps);
+ }
+
+static int ready_guards(llist *l, llist *reps)
+ /* true if every guard in l is a ready_guard_expr */
+ { llist m = *l;
+   guarded_cmnd *gc;
+   rep_stmt *rs;
+   int r = 1;
+   while (r && !llist_is_empty(&m))
+     { gc = llist_head(&m);
+       m = llist_alias_tail(&m);
+       if (gc->class == CLASS_guarded_cmnd)
+         { r = ready_guard_expr(gc->g, reps);
+           continue;
+         }
+       rs = (rep_stmt*)gc;
+       r = ready_index(rs->r.l, reps) && ready_index(rs->r.h, reps);
+       llist_prepend(reps, rs);
+       r = r && ready_guards(&rs->sl, reps);
+       llist_idx_extract(reps, 0);
+     }
+   return r;
+ }
+
+static void sem_ready_guards(parse_obj *x, llist *gl, expr *w)
+ /* Set STMT_ready if the guards of x (gl, or the wait w) can be followed
+  * by a ready_set.
+  */
+ { llist reps;
+   int r;
+   llist_init(&reps);
+   r = gl? ready_guards(gl, &reps) : ready_guard_expr(w, &reps);
+   if (r)
+     { SET_FLAG(x->flags, STMT_ready); }
+   else
+     { RESET_FLAG(x->flags, STMT_ready); }
+ }
+
 static void *sem_loop_stmt(loop_stmt *x, sem_info *f)
  { if (!llist_is_empty(&x->gl))
      { sem_list(&x->gl, f);
        x->glr = llist_copy(&x->gl, 0, 0); /* see sem_select_stmt */
        llist_reverse(&x->glr);
+       sem_ready_guards((parse_obj*)x, &x->gl, 0);
      }
    else
      { sem_stmt_list(&x->sl, f); }
@@ -364,14 +482,17 @@ static void *sem_select_stmt(select_stmt *x, sem_info *f)
           for purpose of printing we keep the original list in order. */
        x->glr = llist_copy(&x->gl, 0, 0);
        llist_reverse(&x->glr);
+       sem_ready_guards((parse_obj*)x, &x->gl, 0);
      }
    else if (IS_SET(x->flags, DEF_forward))
-     { x->w = sem(x->w, f);
+     { sem_not_seq(f);
+       x->w = sem(x->w, f);
        if (IS_SET(x->w->flags, EXPR_port))
          { sem_error(f, x, "Wait expression is a port"); }
        if (x->w->tp.kind != TP_bool)
          { sem_error(f, x->w, "A wait requires a boolean expression"); }
        x->w = mk_const_expr(x->w, f); /* TODO: warn if const */
+       sem_ready_guards((parse_obj*)x, 0, x->w);
      }
    SET_FLAG(x->flags, DEF_forward);
    return x;
@@ -384,6 +505,7 @@ static void *sem_communication(communication *x, sem_info *f)
      }
    if (IS_SET(f->flags, SEM_meta))
      { sem_error(f, x, "A meta process cannot contain communications"); }
+   sem_not_seq(f);
    if (x->op_sym) /* !x->op_sym means that x->p has already been sem'd */
      { x->p = sem(x->p, f); }
    if (x->op_sym == '!')
@@ -706,7 +828,12 @@ static int exec_rep_stmt(rep_stmt *x, exec_info *f)
        return EXEC_next;
      }
    else if (x->rep_sym == ',')
-     { f->curr->i = n;
+     { if (n > ARRAY_REP_MAXSIZE + 1)
+         { clear_value_tp(&ival, f);
+           exec_error(f, x, "Implementation limit exceeded: Replication "
+                      "length %ld > %ld", n - 1, (long)ARRAY_REP_MAXSIZE);
+         }
+       f->curr->i = n;
        f->curr->ps->nr_thread += n - 1; /* one child counts as current thread */
        NEW_ARRAY(rv, n);
        /* rather than permanently allocate a large number of
@@ -843,13 +970,14 @@ static int find_true_guard(void *stmt, exec_info *f)
    rep_stmt *rs = (rep_stmt*)stmt;
    ctrl_state *s;
    sem_context *gcxt = f->gcxt;
-   value_tp ival, gval;
+   value_tp ival, gval, *gv;
    long i, n;
    if (!f->curr->i && f->gc) return 0;
    if (gc->class == CLASS_guarded_cmnd)
-     { eval_expr(gc->g, f);
-       pop_value(&gval, f);
-       if (gval.rep && gval.v.i)
+     { gv = eval_borrow(gc->g, &gval, f);
+       i = gv->rep && gv->v.i;
+       release_borrow(gv, &gval, f);
+       if (i)
          { if (f->gc)
              { true_guard_error(gc, f); }
            f->gc = gc;
@@ -902,10 +1030,262 @@ static void exec_imm_true_guard(exec_info *f)
      }
  }
 
+/* A selection or loop with STMT_ready set keeps a ready_set per process.
+ * It is built the first time the statement is executed, by visiting the
+ * guards in the same order as find_true_guard and compiling each of them
+ * into a wire_expr.  Afterwards the wires keep it up to date, and the first
+ * true guard of the visit order is found among the ready guards only.
+ * Suspending on the set only arms it (rs->act); nothing is allocated.
+ */
+
+typedef struct ready_info
+   { ready_set *rs;
+     int depth; /* nr of guard replicators entered */
+     exec_info *f;
+   } ready_info;
+
+static void ready_wake(ready_set *rs, exec_info *f)
+ /* wake the thread suspended on rs, if any */
+ { if (rs->act && !IS_SET(rs->act->flags, ACTION_sched))
+     { SET_FLAG(rs->act->flags, ACTION_atomic);
+       action_sched(rs->act, f);
+       RESET_FLAG(rs->act->flags, ACTION_atomic);
+     }
+ }
+
+extern void ready_update(ready_guard *g, int val, exec_info *f)
+ { ready_set *rs = g->rs;
+   int i;
+   if (val && g->pos < 0)
+     { g->pos = rs->nr_rdy;
+       rs->rdy[rs->nr_rdy++] = g->i;
+       ready_wake(rs, f);
+     }
+   else if (!val && g->pos >= 0)
+     { i = rs->rdy[--rs->nr_rdy];
+       rs->rdy[g->pos] = i;
+       rs->g[i]->pos = g->pos;
+       g->pos = -1;
+     }
+ }
+
+static int _ready_wprobe_drop(wire_expr *e, exec_info *f)
+ { ready_set *rs;
+   if ((e->flags & WIRE_action) != WIRE_ready) return 0;
+   if (!e->u.rdy)
+     { clear_wire_expr(e, f); /* its ready set was freed */
+       return 1;
+     }
+   rs = e->u.rdy->rs;
+   rs->valid = 0;
+   ready_wake(rs, f);
+   return 1;
+ }
+
+extern void ready_wprobe_drop(wire_value *w, exec_info *f)
+ { if (IS_SET(w->flags, WIRE_has_dep))
+     { dep_list_extract(&w->u.dep, (dep_func*)_ready_wprobe_drop, f); }
+ }
+
+extern void free_ready_sets(process_state *ps, exec_info *f)
+ { ready_set *rs;
+   ready_guard *g;
+   int i, j;
+   while (!llist_is_empty(&ps->ready))
+     { rs = llist_idx_extract(&ps->ready, 0);
+       for (i = 0; i < rs->nr_g; i++)
+         { g = rs->g[i];
+           g->e->u.rdy = 0; /* the wires may outlive ps */
+           for (j = 0; j < g->nr_rv; j++)
+             { clear_value_tp(&g->rv[j], f); }
+           free(g->rv);
+           free(g);
+         }
+       free(rs->g);
+       free(rs->rdy);
+       free(rs);
+     }
+ }
+
+static void ready_set_guard(expr *x, guarded_cmnd *gc, ready_info *g)
+ /* add guard x of gc to g->rs */
+ { exec_info *f = g->f;
+   ready_guard *r;
+   eval_stack *rv;
+   wire_expr *e;
+   wire_value *w;
+   value_tp pval;
+   int i;
+   if (x->class == CLASS_probe)
+     { SET_FLAG(f->flags, EVAL_probe);
+       eval_expr(((probe*)x)->r, f);
+       RESET_FLAG(f->flags, EVAL_probe);
+       pop_value(&pval, f);
+       if (pval.rep != REP_port)
+         { clear_value_tp(&pval, f);
+           g->rs->valid = 0;
+           return;
+         }
+       w = &pval.v.p->wprobe;
+       clear_value_tp(&pval, f);
+       if (!IS_SET(w->flags, WIRE_has_dep))
+         { dep_list_init(&w->u.dep);
+           SET_FLAG(w->flags, WIRE_has_dep);
+         }
+       e = new_wire_expr(f);
+       e->refcnt = 1;
+       e->flags = WIRE_xor | (w->flags & WIRE_value);
+       dep_list_add(&w->u.dep, e);
+     }
+   else
+     { e = make_wire_expr(x, f); }
+   NEW(r);
+   r->e = e;
+   r->rs = g->rs;
+   r->i = g->rs->nr_g;
+   r->pos = -1;
+   r->gc = gc;
+   r->cxt = f->gcxt;
+   r->nr_rv = g->depth;
+   r->rv = 0;
+   if (r->nr_rv)
+     { NEW_ARRAY(r->rv, r->nr_rv); }
+   rv = f->curr->rep_vals;
+   for (i = r->nr_rv - 1; i >= 0; i--)
+     { copy_value_tp(&r->rv[i], &rv->v, f);
+       rv = rv->next;
+     }
+   SET_FLAG(e->flags, WIRE_ready);
+   e->u.rdy = r;
+   REALLOC_ARRAY(g->rs->g, g->rs->nr_g + 1);
+   g->rs->g[g->rs->nr_g++] = r;
+ }
+
+static int ready_set_add(void *stmt, ready_info *g)
+ /* llist_func: add the guards of stmt to g->rs */
+ { guarded_cmnd *gc = (guarded_cmnd*)stmt;
+   rep_stmt *rs = (rep_stmt*)stmt;
+   exec_info *f = g->f;
+   sem_context *gcxt = f->gcxt;
+   value_tp ival;
+   long i, n;
+   if (!g->rs->valid) return 1;
+   if (gc->class == CLASS_guarded_cmnd)
+     { ready_set_guard(gc->g, gc, g); }
+   else if (rs->class == CLASS_rep_stmt)
+     { n = eval_rep_common(&rs->r, &ival, f);
+       push_repval(&ival, f->curr, f);
+       f->gcxt = rs->cxt;
+       g->depth++;
+       for (i = 0; i < n; i++)
+         { llist_apply(&rs->sl, (llist_func*)ready_set_add, g);
+           int_inc(&f->curr->rep_vals->v, f);
+         }
+       g->depth--;
+       f->gcxt = gcxt;
+       pop_repval(&ival, f->curr, f);
+       clear_value_tp(&ival, f);
+     }
+   else
+     { assert(!"Internal error: Expected a guarded command"); }
+   return 0;
+ }
+
+static int ready_set_eq(ready_set *rs, parse_obj *x)
+ { return rs->stmt == x; }
+
+static ready_set *get_ready_set
+(parse_obj *x, llist *glr, expr *w, exec_info *f)
+ /* Return the ready set of x (with guards glr, or wait w) for the current
+  * process, or 0 if the guards of x are to be evaluated normally.  The
+  * ready set is created on first use.
+  */
+ { process_state *ps = f->curr->ps;
+   ready_set *rs;
+   ready_info g;
+   int i;
+   if (!IS_SET(x->flags, STMT_ready) || IS_SET(f->flags, EXEC_immediate)
+       || f->parent || f->curr->var != ps->var)
+     { return 0; }
+   rs = llist_find(&ps->ready, (llist_func*)ready_set_eq, x);
+   if (!rs)
+     { NEW(rs);
+       rs->stmt = x;
+       rs->act = 0;
+       rs->valid = 1;
+       rs->g = 0;
+       rs->nr_g = 0;
+       g.rs = rs; g.depth = 0; g.f = f;
+       f->gcxt = f->curr->cxt;
+       if (glr)
+         { llist_apply(glr, (llist_func*)ready_set_add, &g); }
+       else
+         { ready_set_guard(w, 0, &g); }
+       NEW_ARRAY(rs->rdy, rs->nr_g + 1);
+       rs->nr_rdy = 0;
+       for (i = 0; i < rs->nr_g; i++)
+         { if ((rs->g[i]->e->flags & WIRE_val_mask) == WIRE_value)
+             { rs->g[i]->pos = rs->nr_rdy;
+               rs->rdy[rs->nr_rdy++] = i;
+             }
+         }
+       llist_prepend(&ps->ready, rs);
+     }
+   else if (rs->act == &f->curr->act)
+     { rs->act = 0;
+       RESET_FLAG(f->curr->act.flags, ACTION_ready);
+     }
+   return rs->valid? rs : 0;
+ }
+
+static void ready_push(ready_guard *g, exec_info *f)
+ /* push the replicator values of g */
+ { value_tp v;
+   int i;
+   for (i = 0; i < g->nr_rv; i++)
+     { copy_value_tp(&v, &g->rv[i], f);
+       push_repval(&v, f->curr, f);
+     }
+ }
+
+static void ready_true_guard(ready_set *rs, int mutex, exec_info *f)
+/* Same as find_true_guard_llist, but using the ready guards of rs */
+ { ready_guard *g = 0, *h = 0, *r;
+   eval_stack *rv = f->curr->rep_vals;
+   ctrl_state *s;
+   int i;
+   f->gc = 0;
+   for (i = 0; i < rs->nr_rdy; i++)
+     { r = rs->g[rs->rdy[i]];
+       if (!g || r->i < g->i)
+         { h = g; g = r; }
+       else if (!h || r->i < h->i)
+         { h = r; }
+     }
+   if (!g) return;
+   ready_push(g, f);
+   f->gc = g->gc;
+   f->gcrv = f->curr->rep_vals;
+   f->gccxt = g->cxt;
+   if (mutex && h)
+     { ready_push(h, f);
+       f->gcxt = h->cxt;
+       true_guard_error(h->gc, f);
+     }
+   s = nested_seq(&g->gc->l, f);
+   s->cxt = g->cxt;
+   insert_sched(s, f);
+   f->curr->rep_vals = rv;
+ }
+
 static int exec_loop_stmt(loop_stmt *x, exec_info *f)
  { ctrl_state *s;
+   ready_set *rs;
    if (!llist_is_empty(&x->glr))
-     { while (1)
+     { rs = get_ready_set((parse_obj*)x, &x->glr, 0, f);
+       if (rs)
+         { ready_true_guard(rs, x->mutex, f); }
+       else while (1)
          { f->gc = 0;
            f->gcxt = f->curr->cxt;
            f->curr->i = x->mutex;
@@ -925,9 +1305,20 @@ static int exec_loop_stmt(loop_stmt *x, exec_info *f)
  }
 
 static int exec_select_stmt(select_stmt *x, exec_info *f)
- { value_tp gval;
+ { value_tp gval, *gv;
+   int i;
+   ready_set *rs;
    if (!llist_is_empty(&x->glr))
-     { f->gc = 0;
+     { rs = get_ready_set((parse_obj*)x, &x->glr, 0, f);
+       if (rs && (rs->nr_rdy || !rs->act))
+         { ready_true_guard(rs, x->mutex, f);
+           if (f->gc)
+             { return EXEC_none; }
+           rs->act = &f->curr->act;
+           SET_FLAG(f->curr->act.flags, ACTION_ready);
+           return EXEC_suspend;
+         }
+       f->gc = 0;
        f->gcxt = f->curr->cxt;
        f->curr->i = x->mutex;
        find_true_guard_llist(&x->glr, f);
@@ -947,9 +1338,18 @@ static int exec_select_stmt(select_stmt *x, exec_info *f)
        RESET_FLAG(f->flags, EVAL_probe_wait);
      }
    else
-     { eval_expr(x->w, f);
-       pop_value(&gval, f);
-       if (gval.rep && gval.v.i)
+     { rs = get_ready_set((parse_obj*)x, 0, x->w, f);
+       if (rs && (rs->nr_rdy || !rs->act))
+         { if (rs->nr_rdy)
+             { return EXEC_next; }
+           rs->act = &f->curr->act;
+           SET_FLAG(f->curr->act.flags, ACTION_ready);
+           return EXEC_suspend;
+         }
+       gv = eval_borrow(x->w, &gval, f);
+       i = gv->rep && gv->v.i;
+       release_borrow(gv, &gval, f);
+       if (i)
          { return EXEC_next; }
        SET_FLAG(f->flags, EVAL_probe_wait);
        eval_expr(x->w, f);
@@ -1061,17 +1461,15 @@ static value_tp eval_fn(value_tp *v, function_def *x, exec_info *f)
 
 static void send_error(value_tp *dval, port_value *p, exec_info *f)
  { port_value *pp;
-   llist m, ma;
+   llist ma;
    wire_expr *e, *ea;
    wire_expr_flags afl;
    wire_value *w, *wsent;
-   int count = 0;
+   int i, count = 0;
    assert(IS_SET(p->wprobe.flags, PORT_multiprobe));
    pp = (p->p)? p->p : p->nv->v.p->p;
-   m = pp->wprobe.u.dep;
-   while (!llist_is_empty(&m))
-     { e = llist_head(&m);
-       m = llist_alias_tail(&m);
+   for (i = pp->wprobe.u.dep.nr - 1; i >= 0; i--)
+     { e = DEP_IDX(&pp->wprobe.u.dep, i);
        if (!IS_SET(e->flags, WIRE_llist)) continue;
        ma = e->u.ldep;
        while (!llist_is_empty(&ma))
@@ -1087,13 +1485,13 @@ static void send_error(value_tp *dval, port_value *p, exec_info *f)
    assert(count);
    if (count == 1)
      { exec_error(f, f->curr->obj, "Process %s sent %v on port %v,\n\t"
-                  "but process %s sent %v on port %V", p->wprobe.wps->nm,
-                  vstr_val, dval, vstr_port, p, wsent->wps->nm,
+                  "but process %s sent %v on port %V", ps_name(p->wprobe.wps),
+                  vstr_val, dval, vstr_port, p, ps_name(wsent->wps),
                   vstr_val, &pp->v, vstr_wire, wsent, wsent->wps);
      }
    else
      { exec_error(f, f->curr->obj, "Process %s sent %v on port %v,\n\t"
-                  "but port %V and %d others sent %v", p->wprobe.wps->nm,
+                  "but port %V and %d others sent %v", ps_name(p->wprobe.wps),
                   vstr_val, dval, vstr_port, p, vstr_wire_context, wsent,
                   wsent->wps, count, vstr_val, &pp->v);
      }
@@ -1106,6 +1504,7 @@ static void send_value(value_tp *dval, value_tp *pval, exec_info *f)
  { value_list *dl, *pl;
    value_union *vu;
    value_tp v, *pv;
+   port_buffer *b;
    long i, j;
    assert(pval->rep);
    if (pval->rep == REP_union)
@@ -1124,6 +1523,14 @@ static void send_value(value_tp *dval, value_tp *pval, exec_info *f)
                if (j > 0) j = j << 1;
              }
          }
+       else if (dval->rep == REP_wide)
+         { v.rep = REP_bool;
+           for (i = 0; i < pl->size; i++)
+             { v.v.i = wide_tstbit(dval->v.wd->w, i);
+               send_value(&v, &pl->vl[i], f);
+             }
+           clear_value_tp(dval, f);
+         }
        else if (dval->rep == REP_z)
          { v.rep = REP_bool;
            for (i = 0; i < pl->size; i++)
@@ -1145,7 +1552,11 @@ static void send_value(value_tp *dval, value_tp *pval, exec_info *f)
      }
    else
      { assert(pval->rep == REP_port);
-       if (pval->v.p->p)
+       if (pval->v.p->buf)
+         { b = pval->v.p->buf;
+           pv = &b->v[(b->head + b->cnt) % b->size];
+         }
+       else if (pval->v.p->p)
          { pv = &pval->v.p->p->v; }
        else
          { assert(pval->v.p->nv->rep == REP_port);
@@ -1201,8 +1612,9 @@ extern value_tp receive_value(value_tp *pval, type *tp, exec_info *f)
                  mpz_set_si(dv.v.z->z, lv.v.i);
                }
              else
-               { assert(lv.rep == REP_z);
+               { assert(lv.rep == REP_z || lv.rep == REP_wide);
                  copy_value_tp(&dv, &lv, f);
+                 int_unwide(&dv, f);
                }
              for (i = 0; i < pl->size; i++)
                { v = receive_value(&pl->vl[i], 0, f);
@@ -1238,7 +1650,9 @@ extern value_tp receive_value(value_tp *pval, type *tp, exec_info *f)
            }
        break;
        case REP_port:
-         if (pval->v.p->p)
+         if (pval->v.p->buf)
+           { pv = &pval->v.p->buf->v[pval->v.p->buf->head]; }
+         else if (pval->v.p->p)
            { pv = &pval->v.p->v; }
          else
            { assert(pval->v.p->nv->rep == REP_port);
@@ -1275,7 +1689,9 @@ static void clear_port_value(value_tp *pval, exec_info *f)
            { clear_port_value(&pl->vl[i], f); }
        return;
        case REP_port:
-         if (!IS_SET(pval->v.p->wprobe.flags, PORT_multiprobe))
+         if (pval->v.p->buf)
+           { clear_value_tp(&pval->v.p->buf->v[pval->v.p->buf->head], f); }
+         else if (!IS_SET(pval->v.p->wprobe.flags, PORT_multiprobe))
            { clear_value_tp(&pval->v.p->v, f); }
        return;
        default:
@@ -1283,6 +1699,139 @@ static void clear_port_value(value_tp *pval, exec_info *f)
      }
  }
 
+static int get_buffered(value_tp *pval, exec_info *f)
+ /* Return 1 if the ports of pval belong to native slack channels,
+  * 0 if they do not.  Mixing the two is an error.
+  */
+ { value_list *vl;
+   int i, x;
+   switch (pval->rep)
+     { case REP_union:
+       return get_buffered(&pval->v.u->v, f);
+       case REP_array: case REP_record:
+         vl = pval->v.l;
+         if (!vl->size) return 0;
+         x = get_buffered(&vl->vl[0], f);
+         for (i = 1; i < vl->size; i++)
+           { if (get_buffered(&vl->vl[i], f) != x)
+               { exec_error(f, f->curr->obj, "Communication mixes slack "
+                            "channels with unbuffered channels");
+               }
+           }
+       return x;
+       case REP_port:
+       return pval->v.p->buf != 0;
+       default:
+       return 0;
+     }
+ }
+
+static void slack_sched(port_buffer *b, exec_info *f)
+ /* Schedule b->fwd to raise the probe of the receiving port at the time
+  * that the oldest value in b becomes visible.
+  */
+ { action *a = b->fwd;
+   mpz_set(a->time, b->t[b->head]);
+   pqueue_insert(&f->sched, a);
+   SET_FLAG(a->flags, ACTION_sched);
+   if (f->crit)
+     { *((crit_node**)(a+1)) = f->crit;
+       f->crit->refcnt++;
+     }
+ }
+
+static void slack_advance(value_tp *pval, int send, exec_info *f)
+ /* Pre: all probes of pval are set (i.e., the communication can complete)
+  * Account for one value sent (or received if !send) on the slack channels
+  * of pval, and update the probes of both ports accordingly.
+  */
+ { value_list *vl;
+   port_value *p;
+   port_buffer *b;
+   long i;
+   switch (pval->rep)
+     { case REP_union:
+         slack_advance(&pval->v.u->v, send, f);
+       return;
+       case REP_array: case REP_record:
+         vl = pval->v.l;
+         for (i = 0; i < vl->size; i++)
+           { slack_advance(&vl->vl[i], send, f); }
+       return;
+       case REP_port:
+         p = pval->v.p;
+         b = p->buf;
+       break;
+       default:
+       return;
+     }
+   if (send) /* p->wprobe: room left, p->wpp: value visible */
+     { i = (b->head + b->cnt) % b->size;
+       b->cnt++;
+       if (b->fwd)
+         { mpz_add_ui(b->t[i], f->time, 2 * b->delay); }
+       if (b->cnt == b->size)
+         { write_wire(0, &p->wprobe, f); }
+       if (b->cnt == 1)
+         { if (b->fwd) slack_sched(b, f);
+           else write_wire(1, p->wpp, f);
+         }
+     }
+   else /* p->wprobe: value visible, p->wpp: room left */
+     { b->head = (b->head + 1) % b->size;
+       b->cnt--;
+       if (b->cnt == b->size - 1)
+         { write_wire(1, p->wpp, f); }
+       if (!b->cnt)
+         { write_wire(0, &p->wprobe, f); }
+       else if (b->fwd && mpz_cmp(b->t[b->head], f->time) > 0)
+         { write_wire(0, &p->wprobe, f);
+           slack_sched(b, f);
+         }
+     }
+ }
+
+static int exec_slack_comm(communication *x, value_tp *pval, exec_info *f)
+ /* Pre: x->op_sym != '=', the ports of pval belong to slack channels
+  * Instead of the four phase handshake below, we only need to wait for room
+  * in the buffer (send) or for a value in the buffer (receive).
+  */
+ { value_tp dval;
+   int probe;
+   SET_FLAG(f->flags, EVAL_probe_wait);
+   f->e = 0;
+   probe = get_probe(pval, f);
+   RESET_FLAG(f->flags, EVAL_probe_wait);
+   if (!probe)
+     { clear_value_tp(pval, f);
+       return EXEC_suspend;
+     }
+   if (x->op_sym == '!')
+     { eval_expr(x->e, f);
+       pop_value(&dval, f);
+       if (!dval.rep)
+         { exec_error(f, x, "Sending an unknown value %v", vstr_obj, x->e); }
+       range_check(x->p->tp.tps, &dval, f, x);
+       send_value(&dval, pval, f);
+     }
+   else if (x->op_sym == '?' || x->op_sym == SYM_peek)
+     { if (x->op_sym == SYM_peek) SET_FLAG(f->flags, EVAL_probe);
+       dval = receive_value(pval, &x->p->tp, f);
+       RESET_FLAG(f->flags, EVAL_probe);
+       range_check(x->e->tp.tps, &dval, f, x->e);
+       assign(x->e, &dval, f);
+     }
+   else if (IS_SET(x->p->flags, EXPR_inport))
+     { clear_port_value(pval, f); }
+   if (x->op_sym != SYM_peek)
+     { slack_advance(pval, x->op_sym == '!' || (!x->op_sym &&
+                           !IS_SET(x->p->flags, EXPR_inport)), f);
+     }
+   clear_value_tp(pval, f);
+   f->curr->i = 0;
+   return EXEC_next;
+ }
+
 static int exec_comm_pass(communication *x, exec_info *f)
  /* Pre: x->op_sym = '=' */
  { value_tp pval, qval, v;
@@ -1291,6 +1840,8 @@ static int exec_comm_pass(communication *x, exec_info *f)
    pop_value(&pval, f);
    eval_expr(x->e, f);
    pop_value(&qval, f);
+   if (get_buffered(&pval, f) || get_buffered(&qval, f))
+     { exec_error(f, x, "Cannot pass communications through slack channels"); }
    if (f->curr->i == 1) goto wait1;
    else if (f->curr->i == 2) goto wait2;
    else if (f->curr->i == 3) goto wait3;
@@ -1376,6 +1927,8 @@ static int exec_communication(communication *x, exec_info *f)
    eval_expr(x->p, f);
    RESET_FLAG(f->flags, EVAL_probe);
    pop_value(&pval, f);
+   if (get_buffered(&pval, f))
+     { return exec_slack_comm(x, &pval, f); }
    if (x->op_sym == SYM_peek) goto wait1;
    if (f->curr->i) goto wait1;
    SET_FLAG(f->flags, EVAL_probe_zero | EVAL_probe_wait);
@@ -1426,6 +1979,278 @@ static int exec_communication(communication *x, exec_info *f)
    return EXEC_next;
  }
 
+/* exec_builtin_proc */
+static int exec_builtin_slack(process_state *ps, exec_info *f)
+ /* Replace the slack process ps by a port_buffer that is shared by the two
+  * ports that ps is connected to.  We decline unless both sides are plain
+  * connections (no decompositions, no other slack channels).
+  */
+ { var_decl *di, *dout;
+   meta_parameter *mk, *md;
+   port_value *pi, *po, *s, *r;
+   port_buffer *b;
+   value_tp *k, *d;
+   long i;
+   di = llist_idx(&ps->p->pl, 0);
+   dout = llist_idx(&ps->p->pl, 1);
+   if (ps->var[di->var_idx].rep != REP_port ||
+       ps->var[dout->var_idx].rep != REP_port)
+     { return 0; }
+   pi = ps->var[di->var_idx].v.p;
+   po = ps->var[dout->var_idx].v.p;
+   s = pi->p; r = po->p;
+   if (!s || !r || s->p != pi || r->p != po) return 0;
+   if (pi->dec || po->dec || s->dec || r->dec) return 0;
+   if (pi->buf || po->buf) return 0;
+   if (IS_SET(s->wprobe.flags | r->wprobe.flags, PORT_multiprobe)) return 0;
+   mk = llist_idx(&ps->p->ml, 0);
+   md = llist_idx(&ps->p->ml, 1);
+   k = &ps->meta[mk->meta_idx];
+   d = &ps->meta[md->meta_idx];
+   if (k->rep != REP_int || k->v.i < 1 || k->v.i > ARRAY_REP_MAXSIZE)
+     { exec_error(f, ps->p, "Process %s has slack %v, which is not in "
+                  "1..%d", ps_name(ps), vstr_val, k, ARRAY_REP_MAXSIZE);
+     }
+   if (d->rep != REP_int || d->v.i < 0)
+     { exec_error(f, ps->p, "Process %s has invalid forward latency %v",
+                  ps_name(ps), vstr_val, d);
+     }
+   MALLOC(b, sizeof(*b) + (k->v.i - 1) * sizeof(b->v[0]));
+   b->refcnt = 2;
+   b->size = k->v.i;
+   b->head = b->cnt = 0;
+   b->delay = d->v.i;
+   b->fwd = 0;
+   b->t = 0;
+   for (i = 0; i < b->size; i++)
+     { b->v[i].rep = REP_none; }
+   if (b->delay && !IS_SET(f->user->flags, USER_random))
+     { b->fwd = new_action(f);
+       b->fwd->flags = ACTION_has_up_pr | ACTION_pr_up;
+       b->fwd->target.w = &r->wprobe;
+       NEW_ARRAY(b->t, b->size);
+       for (i = 0; i < b->size; i++)
+         { mpz_init(b->t[i]); }
+     }
+   /* Connect s and r directly, bypassing ps */
+   s->p = r; s->wpp = &r->wprobe; r->wprobe.refcnt++;
+   r->p = s; r->wpp = &s->wprobe; s->wprobe.refcnt++;
+   pi->p = po->p = 0;
+   pi->wpp = po->wpp = 0;
+   pi->wprobe.refcnt--; po->wprobe.refcnt--;
+   s->buf = r->buf = b;
+   SET_FLAG(s->wprobe.flags, WIRE_value); /* the buffer is empty */
+   RESET_FLAG(r->wprobe.flags, WIRE_value);
+   SET_FLAG(ps->flags, PROC_noexec);
+   return 1;
+ }
+
+/* toe1of and frome1of (see channel.chp) convert between a channel and an
+ * e1ofN port.  In random mode, unless traced or shown with -nohide, they
+ * are run by a single native thread (PROC_native), which performs the same
+ * wire transitions and communications as their chp bodies in fewer actions.
+ * Since the thread has no statements, f->curr->i holds its state, and the
+ * rail being handled in the upper bits.
+ */
+
+#define E1OF_STATE(I) ((I) & 7)
+#define E1OF_RAIL(I) ((I) >> 3)
+#define E1OF_SET(S, R) ((S) | ((R) << 3))
+
+typedef struct e1of_ports
+   { value_tp *ch; /* the channel port */
+     wire_value *e; /* the enable */
+     value_list *d; /* the data rails */
+     value_list *map; /* MAP[i] is the value of rail i */
+   } e1of_ports;
+
+static int e1of_get_ports(process_state *ps, int wired, e1of_ports *g)
+ /* Find the ports of converter ps, wired is the index of its e1ofN port.
+  * Return 0 if they are not the plain ports we expect.
+  */
+ { var_decl *d;
+   meta_parameter *m;
+   value_tp *v;
+   long i;
+   if (llist_size(&ps->p->pl) != 2 || llist_size(&ps->p->ml) != 3) return 0;
+   d = llist_idx(&ps->p->pl, 1 - wired);
+   g->ch = &ps->var[d->var_idx];
+   d = llist_idx(&ps->p->pl, wired);
+   v = &ps->var[d->var_idx];
+   m = llist_idx(&ps->p->ml, 2);
+   g->map = ps->meta[m->meta_idx].v.l;
+   if (g->ch->rep != REP_port || v->rep != REP_record || v->v.l->size != 2 ||
+       ps->meta[m->meta_idx].rep != REP_array)
+     { return 0; }
+   if (v->v.l->vl[0].rep != REP_wwire && v->v.l->vl[0].rep != REP_rwire)
+     { return 0; }
+   if (v->v.l->vl[1].rep != REP_array) return 0;
+   g->e = v->v.l->vl[0].v.w;
+   g->d = v->v.l->vl[1].v.l;
+   if (g->d->size != g->map->size) return 0;
+   for (i = 0; i < g->d->size; i++)
+     { if (g->d->vl[i].rep != REP_wwire && g->d->vl[i].rep != REP_rwire)
+         { return 0; }
+     }
+   return 1;
+ }
+
+static int e1of_start(process_state *ps, int wired, exec_info *f)
+ /* Start converter ps natively, or decline */
+ { e1of_ports g;
+   port_value *p;
+   if (IS_SET(ps->flags, DBG_trace) || IS_SET(f->user->flags, USER_nohide))
+     { return 0; }
+   if (!IS_SET(f->user->flags, USER_random))
+     { return 0; } /* -timed, -critical: keep the timing of the chp bodies */
+   if (!e1of_get_ports(ps, wired, &g)) return 0;
+   p = g.ch->v.p;
+   if (!p->p || p->p->p != p || p->buf) return 0;
+   if (IS_SET(p->wprobe.flags | p->p->wprobe.flags, PORT_multiprobe))
+     { return 0; }
+   SET_FLAG(ps->flags, PROC_native);
+   ps->cs->i = 0;
+   insert_sched(ps->cs, f);
+   return 1;
+ }
+
+static int e1of_wire(wire_value *w, int val, exec_info *f)
+ /* Return 1 if w has value val, like [w] or [~w].  Otherwise, wait for w */
+ { if (!IS_SET(w->flags, WIRE_undef) &&
+       (IS_SET(w->flags, WIRE_value) != 0) == val)
+     { return 1; }
+   f->e = 0;
+   add_wire_dep(w, f);
+   return 0;
+ }
+
+static int e1of_probe(value_tp *pval, int zero, exec_info *f)
+ /* Return get_probe(pval), or the zero probe if zero, waiting if false */
+ { int probe;
+   if (zero) SET_FLAG(f->flags, EVAL_probe_zero);
+   SET_FLAG(f->flags, EVAL_probe_wait);
+   f->e = 0;
+   probe = get_probe(pval, f);
+   RESET_FLAG(f->flags, EVAL_probe_wait | EVAL_probe_zero);
+   return probe;
+ }
+
+#define E1OF_WRITE(V, W, F) \
+  write_wire((V), (W), (F)); \
+  if (IS_SET((F)->curr->act.flags, ACTION_delay_susp)) return EXEC_suspend
+
+/* exec_builtin_proc */
+static int exec_builtin_toe1of(process_state *ps, exec_info *f)
+ /* *[ [O.e], I#?x; [<<[]i:0..N-1:x=MAP[i]-> O.d[i]+; [~O.e]; O.d[i]- >>]; I ]
+  */
+ { e1of_ports g;
+   value_tp *pv;
+   long r;
+   if (!IS_SET(ps->flags, PROC_native))
+     { return e1of_start(ps, 1, f); }
+   e1of_get_ports(ps, 1, &g);
+   r = E1OF_RAIL(f->curr->i);
+   while (1)
+     { switch (E1OF_STATE(f->curr->i))
+         { case 0: /* [O.e], I#?x */
+             if (!e1of_wire(g.e, 1, f) | !e1of_probe(g.ch, 0, f))
+               { return EXEC_suspend; }
+             pv = &g.ch->v.p->v;
+             if (!pv->rep)
+               { exec_error(f, ps->p, "Receiving an unknown value"); }
+             for (r = 0; r < g.map->size; r++)
+               { if (equal_value(pv, &g.map->vl[r], f, ps->p)) break; }
+             if (r == g.map->size)
+               { f->e = 0; /* no guard holds */
+                 return EXEC_suspend;
+               }
+             f->curr->i = E1OF_SET(1, r);
+             E1OF_WRITE(1, g.d->vl[r].v.w, f);
+           break;
+           case 1: /* [~O.e]; O.d[i]- */
+             if (!e1of_wire(g.e, 0, f)) return EXEC_suspend;
+             f->curr->i = 2;
+             E1OF_WRITE(0, g.d->vl[r].v.w, f);
+           break;
+           case 2: /* I: wait0 */
+             if (!e1of_probe(g.ch, 1, f)) return EXEC_suspend;
+             set_probe(g.ch, f);
+             f->curr->i = 3;
+           case 3: /* I: wait1 */
+             if (!e1of_probe(g.ch, 0, f)) return EXEC_suspend;
+             clear_port_value(g.ch, f);
+             f->curr->i = 0;
+             SET_FLAG(f->flags, EVAL_probe_zero);
+             set_probe(g.ch, f);
+             RESET_FLAG(f->flags, EVAL_probe_zero);
+             if (IS_SET(f->curr->act.flags, ACTION_delay_susp))
+               { return EXEC_suspend; }
+           break;
+         }
+     }
+ }
+
+/* exec_builtin_proc */
+static int exec_builtin_frome1of(process_state *ps, exec_info *f)
+ /* *[ I.e+; [<<[]i:0..N-1:I.d[i]-> O!MAP[i]; I.e-; [~I.d[i]] >>] ] */
+ { e1of_ports g;
+   value_tp v;
+   long i, r;
+   if (!IS_SET(ps->flags, PROC_native))
+     { return e1of_start(ps, 0, f); }
+   e1of_get_ports(ps, 0, &g);
+   r = E1OF_RAIL(f->curr->i);
+   while (1)
+     { switch (E1OF_STATE(f->curr->i))
+         { case 0: /* I.e+ */
+             f->curr->i = 1;
+             E1OF_WRITE(1, g.e, f);
+           break;
+           case 1: /* [<<[]i:0..N-1:I.d[i]-> ... >>] */
+             r = -1;
+             for (i = 0; i < g.d->size; i++)
+               { if (!IS_SET(g.d->vl[i].v.w->flags, WIRE_undef) &&
+                     IS_SET(g.d->vl[i].v.w->flags, WIRE_value))
+                   { if (r >= 0)
+                       { exec_error(f, ps->p, "Rails I.d[%ld] and I.d[%ld] "
+                                    "are both true", r, i);
+                       }
+                     r = i;
+                   }
+               }
+             if (r < 0)
+               { for (i = 0; i < g.d->size; i++)
+                   { f->e = 0; /* wake up when any rail changes */
+                     add_wire_dep(g.d->vl[i].v.w, f);
+                   }
+                 return EXEC_suspend;
+               }
+             f->curr->i = E1OF_SET(2, r);
+           case 2: /* O!MAP[i]: wait0 */
+             if (!e1of_probe(g.ch, 1, f)) return EXEC_suspend;
+             copy_value_tp(&v, &g.map->vl[r], f);
+             send_value(&v, g.ch, f);
+             set_probe(g.ch, f);
+             f->curr->i = E1OF_SET(3, r);
+           case 3: /* O!MAP[i]: wait1 */
+             if (!e1of_probe(g.ch, 0, f)) return EXEC_suspend;
+             f->curr->i = E1OF_SET(4, r);
+             SET_FLAG(f->flags, EVAL_probe_zero);
+             set_probe(g.ch, f);
+             RESET_FLAG(f->flags, EVAL_probe_zero);
+             if (IS_SET(f->curr->act.flags, ACTION_delay_susp))
+               { return EXEC_suspend; }
+           case 4: /* I.e- */
+             f->curr->i = E1OF_SET(5, r);
+             E1OF_WRITE(0, g.e, f);
+           case 5: /* [~I.d[i]] */
+             if (!e1of_wire(g.d->vl[r].v.w, 0, f)) return EXEC_suspend;
+             f->curr->i = 0;
+           break;
+         }
+     }
+ }
+
 /********** connection *******************************************************/
 
 extern void connect_error(value_tp *v, exec_info *f)
@@ -1436,11 +2261,12 @@ extern void connect_error(value_tp *v, exec_info *f)
      { case REP_port:
          if (v->v.p->p)
            { exec_error(f, x, "Port %v is already connected to %s",
-                        vstr_port, v->v.p, v->v.p->p->wprobe.wps->nm);
+                        vstr_port, v->v.p, ps_name(v->v.p->p->wprobe.wps));
            }
          else if (v->v.p->nv->rep == REP_port)
            { exec_error(f, x, "Port %v is already connected to %s",
-                        vstr_port, v->v.p, v->v.p->nv->v.p->wprobe.wps->nm);
+                        vstr_port, v->v.p,
+                        ps_name(v->v.p->nv->v.p->wprobe.wps));
            }
          else
            { exec_error(f, x,"Port %v is already connected",
@@ -1702,6 +2528,192 @@ extern void wu_procs_remove(port_value *p, exec_info *f)
    SET_FLAG(pp->wprobe.flags, PORT_deadwu);
  }
 
+/* A pair of decomposition processes, one converting a CHP port to the
+ * wires of a union field and one converting these wires back, is only
+ * needed if something else looks at the wires.  Otherwise wu_procs_bypass
+ * connects the two CHP ports directly and terminates both processes.
+ * The wires are still there, but they no longer change.
+ */
+
+static int wu_ports(process_state *ps, port_value **p, value_tp **wv)
+ /* If ps is a live decomposition process, set *p to its default type port
+  * and *wv to its decomposed type port, and return 1.
+  */
+ { var_decl *d0, *d1;
+   value_tp *v0, *v1;
+   if (!IS_SET(ps->flags, PROC_union) || IS_SET(ps->flags, PROC_noexec))
+     { return 0; }
+   d0 = llist_idx(&ps->p->pl, 0);
+   d1 = llist_idx(&ps->p->pl, 1);
+   v0 = &ps->var[d0->var_idx];
+   v1 = &ps->var[d1->var_idx];
+   if (v0->rep == REP_port && v1->rep == REP_record)
+     { *p = v0->v.p; *wv = v1; }
+   else if (v1->rep == REP_port && v0->rep == REP_record)
+     { *p = v1->v.p; *wv = v0; }
+   else
+     { return 0; }
+   return 1;
+ }
+
+static wire_value *wu_first_wire(value_tp *v)
+ /* Return the first wire of v, or 0 if v has none */
+ { long i;
+   wire_value *w;
+   switch (v->rep)
+     { case REP_array: case REP_record:
+         for (i = 0; i < v->v.l->size; i++)
+           { if ((w = wu_first_wire(&v->v.l->vl[i]))) return w; }
+       return 0;
+       case REP_wwire: case REP_rwire:
+       return v->v.w;
+       default:
+       return 0;
+     }
+ }
+
+static void wu_count_wires(value_tp *v, hash_table *h, int add)
+ /* For each wire of v: if add, enter it in h, else count it if it is in h */
+ { long i;
+   hash_entry *q;
+   switch (v->rep)
+     { case REP_array: case REP_record:
+         for (i = 0; i < v->v.l->size; i++)
+           { wu_count_wires(&v->v.l->vl[i], h, add); }
+       return;
+       case REP_union:
+         wu_count_wires(&v->v.u->v, h, add);
+       return;
+       case REP_wwire: case REP_rwire:
+         if (add)
+           { if (!hash_insert(h, (char*)v->v.w, &q)) q->data.i = 0; }
+         else if ((q = hash_find(h, (char*)v->v.w)))
+           { q->data.i++; }
+       return;
+       default:
+       return;
+     }
+ }
+
+static int wu_private_wires(value_tp *a, value_tp *b, hash_table *h)
+ /* true if a and b have the same wires, which nothing else uses */
+ { long i;
+   hash_entry *q;
+   switch (a->rep)
+     { case REP_array: case REP_record:
+         if (b->rep != a->rep || a->v.l->size != b->v.l->size) return 0;
+         for (i = 0; i < a->v.l->size; i++)
+           { if (!wu_private_wires(&a->v.l->vl[i], &b->v.l->vl[i], h))
+               { return 0; }
+           }
+       return 1;
+       case REP_wwire: case REP_rwire: /* written by one, read by the other */
+         if ((b->rep != REP_wwire && b->rep != REP_rwire) || a->v.w != b->v.w)
+           { return 0; }
+         if (IS_SET(a->v.w->flags, WIRE_watch | WIRE_has_dep)) return 0;
+         q = hash_find(h, (char*)a->v.w);
+         return q && q->data.i == 2;
+       default:
+       return 0;
+     }
+ }
+
+static void wu_mark_wires(value_tp *v)
+ /* Set WIRE_bypassed on each wire of v */
+ { long i;
+   switch (v->rep)
+     { case REP_array: case REP_record:
+         for (i = 0; i < v->v.l->size; i++)
+           { wu_mark_wires(&v->v.l->vl[i]); }
+       return;
+       case REP_wwire: case REP_rwire:
+         SET_FLAG(v->v.w->flags, WIRE_bypassed);
+       return;
+       default:
+       return;
+     }
+ }
+
+static void wu_bypass(process_state *ps, process_state *pps, hash_table *h,
+                      exec_info *f)
+ /* Pre: ps and pps share the first wire of their decomposed ports.
+  * If ps and pps implement the same union field in opposite directions,
+  * and only they use the wires in between, connect the ports on the other
+  * sides of ps and pps directly.
+  */
+ { port_value *p, *pp, *s, *r;
+   value_tp *wv, *wvv;
+   union_field *d;
+   if (!wu_ports(ps, &p, &wv) || !wu_ports(pps, &pp, &wvv)) return;
+   s = p->p; r = pp->p;
+   if (!s || !r || s->p != p || r->p != pp) return;
+   d = p->dec? p->dec : s->dec;
+   if (!d || d != (pp->dec? pp->dec : r->dec)) return;
+   if (ps->p == pps->p ||
+       (ps->p != d->up.p && ps->p != d->dn.p) ||
+       (pps->p != d->up.p && pps->p != d->dn.p))
+     { return; }
+   if (p->buf || pp->buf || s->buf || r->buf) return;
+   if (IS_SET(s->wprobe.flags | r->wprobe.flags, PORT_multiprobe)) return;
+   if (IS_SET(s->wprobe.wps->flags | r->wprobe.wps->flags, PROC_noexec))
+     { return; }
+   if (!wu_private_wires(wv, wvv, h)) return;
+   /* Connect s and r directly, bypassing ps and pps */
+   s->p = r; s->wpp = &r->wprobe; r->wprobe.refcnt++;
+   r->p = s; r->wpp = &s->wprobe; s->wprobe.refcnt++;
+   p->p = pp->p = 0;
+   p->wpp = pp->wpp = 0;
+   p->wprobe.refcnt--; pp->wprobe.refcnt--;
+   SET_FLAG(ps->flags, PROC_noexec);
+   SET_FLAG(pps->flags, PROC_noexec);
+   wu_mark_wires(wv);
+ }
+
+extern void wu_procs_bypass(exec_info *f)
+ /* Pre: the wires of f->chp contain no forwards.
+  * Terminate each pair of decomposition processes in f->chp that converts
+  * between two CHP ports, and connect these ports directly.
+  */
+ { hash_table wires, ends;
+   hash_entry *q;
+   llist m, pairs;
+   ctrl_state *cs;
+   process_state *ps;
+   port_value *p;
+   value_tp *wv;
+   wire_value *w;
+   long i;
+   hash_table_init(&wires, 1, HASH_ptr_is_key | HASH_open, 0);
+   hash_table_init(&ends, 1, HASH_ptr_is_key | HASH_open, 0);
+   llist_init(&pairs);
+   for (m = f->chp; !llist_is_empty(&m); m = llist_alias_tail(&m))
+     { cs = llist_head(&m);
+       if (!wu_ports(cs->ps, &p, &wv) || !(w = wu_first_wire(wv))) continue;
+       if (!hash_insert(&ends, (char*)w, &q))
+         { q->data.p = cs->ps; }
+       else if (q->data.p)
+         { llist_prepend(&pairs, q->data.p);
+           llist_prepend(&pairs, cs->ps);
+           q->data.p = 0; /* more sharing processes fail wu_private_wires */
+         }
+       wu_count_wires(wv, &wires, 1);
+     }
+   if (!llist_is_empty(&pairs))
+     { for (m = f->chp; !llist_is_empty(&m); m = llist_alias_tail(&m))
+         { cs = llist_head(&m);
+           if (IS_SET(cs->ps->flags, PROC_noexec)) continue;
+           for (i = 0; i < cs->nr_var; i++)
+             { wu_count_wires(&cs->var[i], &wires, 0); }
+         }
+       while (!llist_is_empty(&pairs))
+         { ps = llist_idx_extract(&pairs, 0);
+           wu_bypass(ps, llist_idx_extract(&pairs, 0), &wires, f);
+         }
+     }
+   hash_table_free(&wires);
+   hash_table_free(&ends);
+ }
+
 static int exec_connection(connection *x, exec_info *f)
  { expr *a, *b;
    process_state *psa, *psb;
@@ -1792,7 +2804,7 @@ static void wire_connect
  * TODO: Seriously, simplify this code
  */
  { int i, a_flag, b_flag;
-   wire_value *wa, *wb;
+   wire_value *wa, *wb, *wt;
    action *wra, *wrb; /* write frames */
    wired_type *wtps;
    llist m;
@@ -1868,12 +2880,17 @@ static void wire_connect
              { exec_error(f, f->curr->obj, "Incompatible initial values"
                           "in connect");
              }
+           if (wb->refcnt > wa->refcnt)
+             { /* union by size: forward the less referenced wire */
+               ASSIGN_FLAG(wb->flags, wa->flags, WIRE_val_mask);
+               wt = wa; wa = wb; wb = wt;
+             }
            SET_FLAG(wb->flags, WIRE_forward);
            wb->u.w = wa;
            wb->refcnt--;
            if (!wb->refcnt) free(wb);
            else wa->refcnt++;
-           vb->v.w = wa;
+           va->v.w = vb->v.w = wa;
          }
        /* now va->w == vb->w = wa */
        wa->refcnt++;
@@ -1981,7 +2998,8 @@ static int exec_meta_binding(meta_binding *x, exec_info *f)
 
 
 static void mk_instance(value_tp *xval, type *tp, exec_info *f)
- /* Pre: tp is the type or subtype of an instance_decl.
+ /* Pre: tp is the type or subtype of an instance_decl, f->scratch is
+    the name of the instance within f->curr->ps.
     Create the process states.
  */
  { process_state *ps;
@@ -2003,7 +3021,7 @@ static void mk_instance(value_tp *xval, type *tp, exec_info *f)
      }
    else
      { assert(tp->kind == TP_process); 
-       ps = new_process_state(f, make_str(f->scratch.s));
+       ps = new_child_process_state(f, f->curr->ps, make_str(f->scratch.s));
        ps->p = tp->elem.p;
        ps->nr_meta = ps->p->nr_meta;
        if (ps->nr_meta)
@@ -2034,10 +3052,7 @@ static void mk_instance(value_tp *xval, type *tp, exec_info *f)
 static int exec_instance_stmt(instance_stmt *x, exec_info *f)
  { value_tp *v;
    v = &f->curr->var[x->d->var_idx];
-   if (f->curr->ps->nm == make_str("/"))
-     { var_str_printf(&f->scratch, 0, "/%s", x->d->id); }
-   else
-     { var_str_printf(&f->scratch, 0, "%s/%s", f->curr->ps->nm, x->d->id); }
+   var_str_copy(&f->scratch, x->d->id);
    mk_instance(v, &x->d->tp, f);
    if (x->mb)
      { exec_meta_binding_aux(x->mb, v, f); }
@@ -2051,7 +3066,7 @@ static void _lookup_pr
 /* find all production rules with w as target */
  { int i;
    wire_expr *e;
-   llist l;
+   dep_list *d;
    switch (v->rep)
      { case REP_array: case REP_record:
          for (i = 0; i < v->v.l->size; i++)
@@ -2060,20 +3075,20 @@ static void _lookup_pr
        case REP_wwire: case REP_rwire:
          if (f->curr->obj->class == CLASS_delay_hold) return;
          if (!IS_SET(v->v.w->flags, WIRE_has_dep)) return;
-         l = v->v.w->u.dep;
+         d = &v->v.w->u.dep;
        break;
        case REP_cnt:
          if (f->curr->obj->class != CLASS_delay_hold) return;
-         l = v->v.c->dep;
+         d = &v->v.c->dep;
        break;
        default:
        return;
      }
-   while (!llist_is_empty(&l))
-     { e = llist_head(&l);
-       l = llist_alias_tail(&l);
+   for (i = d->nr - 1; i >= 0; i--)
+     { e = DEP_IDX(d, i);
        while (!IS_SET(e->flags, WIRE_action))
          { e = e->u.dep; }
+       if ((e->flags & WIRE_action) == WIRE_ready) continue;
        if (e->u.hold != w && e->u.act->target.w != w) continue;
        if (IS_SET(e->flags, WIRE_pu))
          { assert(!*pu || *pu == e); *pu = e; }
@@ -2135,7 +3150,7 @@ static int exec_production_rule(production_rule *x, exec_info *f)
    if (x->delay)
      { eval_expr(x->delay, f);
        pop_value(&dval, f);
-       if (dval.rep == REP_z)
+       if (dval.rep == REP_z || dval.rep == REP_wide)
          { exec_error(f, x, "Delay value %v is too large", vstr_val, &dval); }
        if (dval.v.i < 0)
          { exec_error(f, x, "Delay value %d is negative", dval.v.i); }
@@ -2201,7 +3216,7 @@ static int exec_delay_hold(delay_hold *x, exec_info *f)
        if (!IS_SET(h->flags, WIRE_value))
          { SET_FLAG(v.v.w->flags, ishu? WIRE_held_up : WIRE_held_dn); }
        e->refcnt++;
-       llist_prepend(&c->dep, e);
+       dep_list_add(&c->dep, e);
        m = llist_alias_tail(&m);
      }
    return EXEC_next;
@@ -2214,7 +3229,7 @@ static int exec_property_stmt(property_stmt *x, exec_info *f)
    assert(node.rep == REP_wwire || node.rep == REP_rwire);
    eval_expr(x->v, f);
    pop_value(&v, f);
-   if (v.rep == REP_z)
+   if (v.rep == REP_z || v.rep == REP_wide)
      { exec_error(f, x, "Property value %v is too large", vstr_val, &v); }
    assert(v.rep == REP_int);
    add_property(x->id, node.v.w, v.v.i, f->prop);
@@ -2361,6 +3376,9 @@ extern void init_statement(void)
    set_brk(guarded_cmnd);
    set_brk(loop_stmt);
    set_brk(select_stmt);
+   set_builtin_proc("slack", exec_builtin_slack);
+   set_builtin_proc("toe1of", exec_builtin_toe1of);
+   set_builtin_proc("frome1of", exec_builtin_frome1of);
 
    /* Set up the const frame used by const_wired_connection */
    const_frame_ps.nm = make_str("//const");
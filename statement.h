@@ -73,6 +73,23 @@ extern void wu_procs_remove(port_value *p, exec_info *f);
   * connected ports to being terminated with forwarded ports. 
   */
 
+extern void wu_procs_bypass(exec_info *f);
+ /* Pre: the wires of f->chp contain no forwards.
+  * Terminate each pair of decomposition processes in f->chp that converts
+  * between two CHP ports, and connect these ports directly.
+  */
+
+extern void ready_update(ready_guard *g, int val, exec_info *f);
+ /* Called when the wire followed by g changes to val (see ready_set) */
+
+extern void ready_wprobe_drop(wire_value *w, exec_info *f);
+ /* Stop following wire w with any ready set; used before w is freed */
+
+extern void free_ready_sets(process_state *ps, exec_info *f);
+ /* Free the ready sets of ps.  Their wire_exprs are left in the dependency
+    lists of the wires, which may outlive ps, but no longer refer to them.
+ */
+
 extern void sem_meta_binding_aux(process_def *d, meta_binding *x, sem_info *f);
 /* If x->x is not valid and the process for binding (d) can be found
  * elsewhere, then use this instead of sem(x, f)
@@ -620,12 +620,8 @@ extern int type_compatible(type *tp1, type *tp2)
    return 0;
  }
 
-extern int type_compatible_exec(type *tp1, process_state *ps1,
-                                type *tp2, process_state *ps2, exec_info *f)
- /* Execution time type checking.  Verify that the specific types are
-    identical ignoring union type differences.  Specifying a process_state
-    for each type allows us to look up the real value for generic types.
- */
+static int _type_compatible_exec(type *tp1, process_state *ps1,
+                                 type *tp2, process_state *ps2, exec_info *f)
  { llist m1, m2;
    wired_type *w1, *w2;
    wire_decl *d1, *d2;
@@ -756,6 +752,80 @@ extern int type_compatible_exec(type *tp1, process_state *ps1,
    return 0;
  }
 
+#define EXPR_instance (EXPR_meta | EXPR_cparam | EXPR_rep | EXPR_generic)
+
+static int type_is_fixed(type *tp)
+ /* true if tp does not depend on the process_state it is evaluated in */
+ { llist m;
+   wired_type *w;
+   wire_decl *d;
+   integer_type *itps;
+   array_type *atps;
+   int i;
+   switch (tp->kind)
+     { case TP_int:
+          itps = (integer_type*)tp->tps;
+          if (!itps || itps->class != CLASS_integer_type) return 1;
+       return !IS_SET(itps->l->flags | itps->h->flags, EXPR_instance);
+       case TP_array:
+          atps = (array_type*)tp->tps;
+          if (IS_SET(atps->l->flags | atps->h->flags, EXPR_instance))
+            { return 0; }
+       return type_is_fixed(tp->elem.tp);
+       case TP_record:
+          m = tp->elem.l;
+          while (!llist_is_empty(&m))
+            { if (!type_is_fixed(llist_head(&m))) return 0;
+              m = llist_alias_tail(&m);
+            }
+       return 1;
+       case TP_wire:
+          w = (wired_type*)tp->tps;
+          m = w->li;
+          for (i = 0; i < 2; i++)
+            { while (!llist_is_empty(&m))
+                { d = llist_head(&m);
+                  if (!type_is_fixed(&d->tps->tp)) return 0;
+                  m = llist_alias_tail(&m);
+                }
+              m = w->lo;
+            }
+       return 1;
+       case TP_generic:
+       return 0;
+       default:
+       return 1;
+     }
+ }
+
+extern int type_compatible_exec(type *tp1, process_state *ps1,
+                                type *tp2, process_state *ps2, exec_info *f)
+ /* Execution time type checking.  Verify that the specific types are
+    identical ignoring union type differences.  Specifying a process_state
+    for each type allows us to look up the real value for generic types.
+    During instantiation, compatible pairs of structured types are kept in
+    f->compat.  Pairs of types that do not depend on meta parameters are
+    kept without their process_states, so connecting the same ports of
+    many instances, or many elements of the same array, compares the types
+    only once.
+ */
+ { type_pair key;
+   if (!IS_SET(f->flags, EXEC_instantiation) || !f->compat ||
+       (tp1->kind != TP_array && tp1->kind != TP_record &&
+        tp1->kind != TP_wire && tp1->kind != TP_int))
+     { return _type_compatible_exec(tp1, ps1, tp2, ps2, f); }
+   key.tp1 = tp1; key.ps1 = 0;
+   key.tp2 = tp2; key.ps2 = 0;
+   if (hash_find(f->compat, (char*)&key)) return 1;
+   if (!type_is_fixed(tp1) || !type_is_fixed(tp2))
+     { key.ps1 = ps1; key.ps2 = ps2;
+       if (hash_find(f->compat, (char*)&key)) return 1;
+     }
+   if (!_type_compatible_exec(tp1, ps1, tp2, ps2, f)) return 0;
+   hash_insert(f->compat, (char*)&key, 0);
+   return 1;
+ }
+
 static void range_type_def(type_def *x, exec_info *f)
  /* This should only happen with builtin types */
  { value_list *l;
@@ -778,12 +848,21 @@ static void range_integer_type(integer_type *x, exec_info *f)
  { value_tp lval, hval, dval;
    int under, over;
    long n;
-   if(f->val->rep != REP_int && f->val->rep != REP_z)
+   if(f->val->rep != REP_int && f->val->rep != REP_z &&
+      f->val->rep != REP_wide)
      { exec_error(f, f->err_obj, "Type mismatch"); }
    eval_expr(x->l, f);
    pop_value(&lval, f);
    eval_expr(x->h, f);
    pop_value(&hval, f);
+   if (lval.rep == REP_int && hval.rep == REP_int &&
+       !IS_SET(x->l->flags, EXPR_all_const) &&
+       !IS_SET(x->h->flags, EXPR_all_const))
+     { /* same bounds for every instance: let range_check do the work */
+       x->lo = lval.v.i;
+       x->hi = hval.v.i;
+       SET_FLAG(x->flags, TYPE_bounds);
+     }
    under = int_cmp(f->val, &lval, f) < 0; /* fval < lval */
    over = int_cmp(&hval, f->val, f) < 0; /* hval < fval */
    if (IS_SET(f->flags, EVAL_bit))
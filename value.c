@@ -56,6 +56,7 @@
 #include "routines.h"
 #include "expr.h"
 #include "types.h"
+#include "statement.h"
 
 /*extern*/ int app_eval = -1;
 /*extern*/ int app_reval = -1;
@@ -67,22 +68,17 @@
 
 extern void push_value(value_tp *v, exec_info *f)
  /* push *v on stack (direct copy: top = *v) */
- { eval_stack *w;
-   if (f->fl)
-     { w = f->fl; f->fl = w->next; }
-   else
-     { NEW(w); }
-   w->v = *v;
-   w->next = f->stack; f->stack = w;
+ { if (f->nr_stack == f->max_stack)
+     { f->max_stack = f->max_stack? 2 * f->max_stack : EVAL_STACK_MINSIZE;
+       REALLOC_ARRAY(f->stack, f->max_stack);
+     }
+   f->stack[f->nr_stack++] = *v;
  }
 
 extern void pop_value(value_tp *v, exec_info *f)
  /* store top of stack in *v (direct copy: *v = top) and pop stack */
- { eval_stack *w;
-   assert(f->stack);
-   w = f->stack; f->stack = w->next;
-   *v = w->v;
-   w->next = f->fl; f->fl = w;
+ { assert(f->nr_stack);
+   *v = f->stack[--f->nr_stack];
  }
 
 extern void push_repval(value_tp *v, ctrl_state *cs, exec_info *f)
@@ -111,30 +107,69 @@ static void no_eval(expr *x, exec_info *f)
          "Object class %s has no eval method", x->class->nm);
  }
 
+static value_tp *reval_read(expr *x, exec_info *f)
+ /* Pre: x is an lvalue. Return the stored value of x for reading */
+ { value_tp *xv;
+   exec_flags flags;
+   flags = f->flags;
+   RESET_FLAG(f->flags, EVAL_assign);
+   xv = reval_expr(x, f);
+   ASSIGN_FLAG(f->flags, flags, EVAL_assign);
+   if (IS_SET(x->flags, EXPR_ifrchk))
+     { f->err_obj = x;
+       if (IS_SET(x->flags, EXPR_port) && !IS_SET(f->flags, EVAL_probe))
+         { strict_check_write(xv, f); }
+       else
+         { strict_check_read(xv, f); }
+     }
+   return xv;
+ }
+
 extern void eval_expr(void *obj, exec_info *f)
  /* Evaluate expr *obj */
  { expr *x = obj;
    value_tp *xv, xval;
-   exec_flags flags;
    if (IS_SET(x->flags, EXPR_lvalue))
-     { flags = f->flags;
-       RESET_FLAG(f->flags, EVAL_assign);
-       xv = reval_expr(x, f);
-       ASSIGN_FLAG(f->flags, flags, EVAL_assign);
-       if (IS_SET(x->flags, EXPR_ifrchk))
-         { f->err_obj = x;
-           if (IS_SET(x->flags, EXPR_port) && !IS_SET(f->flags, EVAL_probe))
-             { strict_check_write(xv, f); }
-           else
-             { strict_check_read(xv, f); }
-         }
-       alias_value_tp(&xval, xv, f);
+     { xv = reval_read(x, f);
+       if (xv->rep == REP_packed)
+         { packed_read(&xval, xv, f); }
+       else
+         { alias_value_tp(&xval, xv, f); }
        push_value(&xval, f);
      }
    else
      { APP_OBJ_VFZ(app_eval, obj, f, no_eval); }
  }
 
+extern value_tp *eval_borrow(void *obj, value_tp *tmp, exec_info *f)
+ /* Evaluate expr *obj without taking a reference to it.  Returns either
+    a pointer to the stored value, which must not be changed or kept, or
+    tmp, which then holds the value.  Release with release_borrow().
+ */
+ { expr *x = obj;
+   value_tp *xv;
+   if (IS_SET(x->flags, EXPR_lvalue))
+     { xv = reval_read(x, f);
+       if (xv->rep == REP_packed)
+         { packed_read(tmp, xv, f); }
+       else if (xv == &f->pkv) /* overwritten by the next packed_reval() */
+         { alias_value_tp(tmp, xv, f); }
+       else
+         { return xv; }
+     }
+   else
+     { APP_OBJ_VFZ(app_eval, obj, f, no_eval);
+       pop_value(tmp, f);
+     }
+   return tmp;
+ }
+
+extern void release_borrow(value_tp *v, value_tp *tmp, exec_info *f)
+ /* Release value v returned by eval_borrow(obj, tmp, f) */
+ { if (v == tmp)
+     { clear_value_tp(tmp, f); }
+ }
+
 static void *no_reval(expr *x, exec_info *f)
  /* called when x has no eval function */
  { error("Internal error: "
@@ -170,6 +205,7 @@ extern void print_value_tp(value_tp *v, print_info *f)
  { char bo = '{', bc = '}';
    wire_value *w;
    int i, n;
+   mpz_t z;
    switch (v->rep)
      { case REP_none: print_char('?', f);
        break;
@@ -184,6 +220,14 @@ extern void print_value_tp(value_tp *v, print_info *f)
                 mpz_get_str(f->s->s + f->pos, 10, v->v.z->z);
                 f->pos += strlen(f->s->s + f->pos);
        break;
+       case REP_wide:
+                mpz_init(z);
+                wide_get_z(z, v->v.wd->w);
+                var_str_ensure(f->s, f->pos + mpz_sizeinbase(z, 10)+1);
+                mpz_get_str(f->s->s + f->pos, 10, z);
+                f->pos += strlen(f->s->s + f->pos);
+                mpz_clear(z);
+       break;
        case REP_symbol:
                 print_char('`', f);
                 print_string(v->v.s, f);
@@ -201,6 +245,9 @@ extern void print_value_tp(value_tp *v, print_info *f)
                   }
                 print_char(bc, f);
        break;
+       case REP_packed:
+                print_packed_value(v, f);
+       break;
        case REP_union:
                 print_value_tp(&v->v.u->v, f);
        break;
@@ -227,14 +274,17 @@ extern void print_value_tp(value_tp *v, print_info *f)
        break;
        case REP_process:
                 print_string("process ", f);
-                print_string(v->v.ps->nm, f);
+                print_string(ps_name(v->v.ps), f);
        break;
        case REP_wwire: case REP_rwire:
                 w = v->v.w;
                 while (IS_SET(w->flags, WIRE_forward)) w = w->u.w;
-                f->pos += var_str_printf(f->s, f->pos, "(%c)",
+                f->pos += var_str_printf(f->s, f->pos, "(%c%s)",
                               IS_SET(w->flags, WIRE_undef)?
-                                'X' : '0' + IS_SET(w->flags, WIRE_value));
+                                'X' : '0' + IS_SET(w->flags, WIRE_value),
+                              IS_SET(w->flags, WIRE_pruned)? ", pruned" :
+                              IS_SET(w->flags, WIRE_bypassed)?
+                                ", not driven" : "");
        break;
        case REP_cnt:
                 f->pos += var_str_printf(f->s, f->pos, "%d", v->v.c->cnt);
@@ -266,9 +316,12 @@ extern int print_string_value(var_string *s, int pos, value_tp *val)
        if (!ev->rep)
          { VAR_STR_X(s, pos) = '?'; pos++; r++; }
        else
-         { assert(ev->rep == REP_int || ev->rep == REP_z);
+         { assert(ev->rep == REP_int || ev->rep == REP_z ||
+                  ev->rep == REP_wide);
            if (ev->rep == REP_int)
              { c = ev->v.i; }
+           else if (ev->rep == REP_wide)
+             { c = ev->v.wd->w[0]; }
            else
              { c = mpz_get_si(ev->v.z->z); }
            if (!c)
@@ -399,8 +452,8 @@ extern void print_wire_exec(wire_value *w, exec_info *f)
    value_tp *var = f->meta_ps->var;
    wire_expr *e;
    while (IS_SET(w->flags, WIRE_virtual))
-     { assert(llist_size(&w->u.dep) == 1);
-       e = llist_head(&w->u.dep);
+     { assert(w->u.dep.nr == 1);
+       e = DEP_IDX(&w->u.dep, 0);
        assert(IS_SET(e->flags, WIRE_x));
        w = e->u.hold;
      }
@@ -454,7 +507,9 @@ extern int vstr_wire_context(var_string *s, int pos, void *w, void *ps)
    exec_info_init_eval(&g, ps);
    print_wire_exec(w, &g);
    if (is_visible(ps))
-     { var_str_printf(s, pos, "%s of process %s", g.scratch.s, g.meta_ps->nm); }
+     { var_str_printf(s, pos, "%s of process %s",
+                      g.scratch.s, ps_name(g.meta_ps));
+     }
    else
      { ext = strchr(g.scratch.s, '.'); /* "Remove" local port name */
        if (!ext) ext = ""; /* Sometimes the local port name is all there is */
@@ -466,11 +521,11 @@ extern int vstr_wire_context(var_string *s, int pos, void *w, void *ps)
        assert(pv->dec);
        if (w == &pv->wprobe)
          { var_str_printf(s, pos, "%v%s of process %s", vstr_port, pv->p,
-                          ext, pv->p->wprobe.wps->nm);
+                          ext, ps_name(pv->p->wprobe.wps));
          }
        else
          { var_str_printf(s, pos, "%v.%s%s of process %s", vstr_port, pv->p,
-                          pv->dec->id, ext, pv->p->wprobe.wps->nm);
+                          pv->dec->id, ext, ps_name(pv->p->wprobe.wps));
          }
      }
    exec_info_term(&g);
@@ -487,7 +542,7 @@ extern int vstr_wire_context_short(var_string *s, int pos, void *w, void *ps)
    exec_info_init_eval(&g, ps);
    print_wire_exec(w, &g);
    if (is_visible(ps))
-     { var_str_printf(s, pos, "%s:%s", g.meta_ps->nm, g.scratch.s); }
+     { var_str_printf(s, pos, "%s:%s", ps_name(g.meta_ps), g.scratch.s); }
    else
      { ext = strchr(g.scratch.s, '.'); /* "Remove" local port name */
        if (!ext) ext = ""; /* Sometimes the local port name is all there is */
@@ -498,11 +553,11 @@ extern int vstr_wire_context_short(var_string *s, int pos, void *w, void *ps)
        pv = g.meta_ps->var[d->var_idx].v.p; /* The "real" port */
        assert(pv->dec);
        if (w == &pv->wprobe)
-         { var_str_printf(s, pos, "%s:%v%s", pv->p->wprobe.wps->nm,
+         { var_str_printf(s, pos, "%s:%v%s", ps_name(pv->p->wprobe.wps),
                           vstr_port, pv->p, ext);
          }
        else
-         { var_str_printf(s, pos, "%s:%v.%s%s", pv->p->wprobe.wps->nm,
+         { var_str_printf(s, pos, "%s:%v.%s%s", ps_name(pv->p->wprobe.wps),
                           vstr_port, pv->p, pv->dec->id, ext);
          }
      }
@@ -583,7 +638,7 @@ extern int print_port_connect(port_value *p, print_info *f)
        exec_info_term(&g);
      }
    else
-     { print_string(ps->nm, f);
+     { print_string(ps_name(ps), f);
        print_char(':', f);
        print_port_value(p, f);
      }
@@ -636,6 +691,7 @@ extern port_value *new_port_value(process_state *ps, exec_info *f)
    p->v.rep = REP_none;
    p->dec = 0;
    p->nv = 0;
+   p->buf = 0;
    return p;
  }
 
@@ -665,26 +721,62 @@ extern counter_value *new_counter_value(long x, exec_info *f)
    NEW(c);
    c->refcnt = 1;
    c->cnt = x;
-   llist_init(&c->dep);
+   dep_list_init(&c->dep);
    return c;
  }
 
 extern void wire_fix(wire_value **w, exec_info *f)
 /* Remove all wire forwarding from w
  * Returned wire value is not reference counted
+ * Every forwarded wire on the way is made to point directly at the
+ * result (path compression); those no longer referenced are freed.
  */
- { wire_value *ww = *w;
-   if (!IS_SET(ww->flags, WIRE_forward)) return;
-   wire_fix(&ww->u.w, f);
-   *w = ww->u.w;
-   ww->refcnt--;
-   if (!ww->refcnt) free(ww);
-   else ww->u.w->refcnt++;
+ { wire_value *r, *n, *next, *tmp, **p = w;
+   for (r = *w; IS_SET(r->flags, WIRE_forward); r = r->u.w) ;
+   n = *w;
+   while (n != r)
+     { next = n->u.w;
+       if (p != &tmp) /* tmp is a reference held by a freed wire */
+         { *p = r;
+           r->refcnt++;
+         }
+       n->refcnt--;
+       if (n->refcnt)
+         { p = &n->u.w; }
+       else
+         { free(n);
+           p = &tmp;
+           if (next == r) r->refcnt--;
+         }
+       n = next;
+     }
+ }
+
+static void free_port_buffer(port_buffer *b, exec_info *f)
+ /* deallocate slack buffer b, including any values still in it */
+ { long i;
+   for (i = 0; i < b->size; i++)
+     { clear_value_tp(&b->v[i], f); }
+   if (b->t)
+     { for (i = 0; i < b->size; i++)
+         { mpz_clear(b->t[i]); }
+       free(b->t);
+     }
+   if (b->fwd && !IS_SET(b->fwd->flags, ACTION_sched))
+     { mpz_clear(b->fwd->time);
+       free(b->fwd);
+     } /* else the scheduler still refers to it */
+   free(b);
  }
 
 static void free_port_value(port_value *p, exec_info *f)
  /* disconnect and deallocate p */
  { assert(!p->p);
+   if (p->buf)
+     { p->buf->refcnt--;
+       if (!p->buf->refcnt)
+         { free_port_buffer(p->buf, f); }
+     }
    free(p);
  }
 
@@ -697,6 +789,83 @@ extern z_value *new_z_value(exec_info *f)
    return z;
  }
 
+/* Released wide_values, kept so that arithmetic on wide buses does not
+   call malloc on each step.
+*/
+static wide_value *wide_pool[WIDE_REP_POOLSIZE];
+static int wide_pool_nr = 0;
+
+extern wide_value *new_wide_value(exec_info *f)
+ /* allocate a new wide_value (the words are not initialized) */
+ { wide_value *wd;
+   if (wide_pool_nr)
+     { wd = wide_pool[--wide_pool_nr]; }
+   else
+     { NEW(wd); }
+   wd->refcnt = 1;
+   return wd;
+ }
+
+static void free_wide_value(wide_value *wd, exec_info *f)
+ /* deallocate wd, or keep it for reuse */
+ { if (wide_pool_nr < WIDE_REP_POOLSIZE)
+     { wide_pool[wide_pool_nr++] = wd; }
+   else
+     { free(wd); }
+ }
+
+extern void wide_get_z(mpz_t z, const ulong *w)
+ /* Set z to the value of the WIDE_REP_NRWORD words w */
+ { ulong cw[WIDE_REP_NRWORD];
+   int i;
+   if ((long)w[WIDE_REP_NRWORD - 1] >= 0)
+     { mpz_import(z, WIDE_REP_NRWORD, -1, sizeof(ulong), 0, 0, w);
+       return;
+     }
+   for (i = 0; i < WIDE_REP_NRWORD; i++)
+     { cw[i] = ~w[i]; }
+   mpz_import(z, WIDE_REP_NRWORD, -1, sizeof(ulong), 0, 0, cw);
+   mpz_com(z, z); /* w = ~cw = -cw - 1 */
+ }
+
+extern int wide_set_z(ulong *w, mpz_t z)
+ /* If |z| < 2^WIDE_REP_NRBITS, set the WIDE_REP_NRWORD words w to z and
+    return 1; otherwise return 0.
+ */
+ { int i, c = 1;
+   if (mpz_sizeinbase(z, 2) > WIDE_REP_NRBITS) return 0;
+   for (i = 0; i < WIDE_REP_NRWORD; i++)
+     { w[i] = 0; }
+   mpz_export(w, 0, -1, sizeof(ulong), 0, 0, z); /* |z| */
+   if (mpz_sgn(z) < 0)
+     { for (i = 0; i < WIDE_REP_NRWORD; i++)
+         { w[i] = ~w[i] + c;
+           c = c && !w[i];
+         }
+     }
+   return 1;
+ }
+
+extern int wide_tstbit(const ulong *w, long i)
+ /* Return bit i of the WIDE_REP_NRWORD words w */
+ { if (i >= WIDE_REP_NRWORD * INT_REP_NRBITS)
+     { i = WIDE_REP_NRWORD * INT_REP_NRBITS - 1; }
+   return (w[i / INT_REP_NRBITS] >> (i % INT_REP_NRBITS)) & 1;
+ }
+
+extern void int_unwide(value_tp *v, exec_info *f)
+ /* If v is REP_wide, replace it by the same value as REP_z */
+ { z_value *vz;
+   if (v->rep != REP_wide) return;
+   vz = new_z_value(f);
+   wide_get_z(vz->z, v->v.wd->w);
+   clear_value_tp(v, f);
+   v->rep = REP_z;
+   v->v.z = vz;
+ }
+
+static void free_packed_value(packed_value *k, exec_info *f);
+
 extern void clear_value_tp(value_tp *v, exec_info *f)
  /* Reset v to have no value. If v has allocated memory (e.g., for array),
     free that if there are no longer any references to it.
@@ -719,6 +888,11 @@ extern void clear_value_tp(value_tp *v, exec_info *f)
              free(vz);
            }
        break;
+       case REP_wide:
+         v->v.wd->refcnt--;
+         if (!v->v.wd->refcnt)
+           { free_wide_value(v->v.wd, f); }
+       break;
        case REP_array: case REP_record:
          vl = v->v.l;
          vl->refcnt--;
@@ -764,7 +938,11 @@ extern void clear_value_tp(value_tp *v, exec_info *f)
          w->refcnt--;
          while (!w->refcnt)
            { if (!IS_SET(w->flags, WIRE_forward))
-               { free(w); break; }
+               { if (IS_SET(w->flags, WIRE_has_dep))
+                   { dep_list_free(&w->u.dep); }
+                 free(w);
+                 break;
+               }
              ww = w->u.w;
              free(w);
              w = ww;
@@ -775,7 +953,14 @@ extern void clear_value_tp(value_tp *v, exec_info *f)
          c = v->v.c;
          c->refcnt--;
          if (!c->refcnt)
-           { free(c); }
+           { dep_list_free(&c->dep);
+             free(c);
+           }
+       break;
+       case REP_packed:
+         v->v.k->refcnt--;
+         if (!v->v.k->refcnt)
+           { free_packed_value(v->v.k, f); }
        break;
        default:
        break;
@@ -784,23 +969,16 @@ extern void clear_value_tp(value_tp *v, exec_info *f)
  }
 
 extern void copy_value_tp(value_tp *w, value_tp *v, exec_info *f)
- /* Copy v to w, allocating new memory */
- { int i;
-   value_list *vl, *wl;
-   value_union *vu, *wu;
+ /* Copy v to w, allocating new memory.  The value_list of an array or
+    record is shared instead; use unshare_value() before modifying it.
+ */
+ { value_union *vu, *wu;
    switch (v->rep)
      { case REP_z:
          w->rep = REP_z;
          w->v.z = new_z_value(f);
          mpz_set(w->v.z->z, v->v.z->z);
        return;
-       case REP_array: case REP_record:
-         w->rep = v->rep;
-         vl = v->v.l;
-         w->v.l = wl = new_value_list(vl->size, f);
-         for (i = 0; i < vl->size; i++)
-           { copy_value_tp(&wl->vl[i], &vl->vl[i], f); }
-       return;
        case REP_union:
          w->rep = REP_union;
          vu = v->v.u;
@@ -810,20 +988,51 @@ extern void copy_value_tp(value_tp *w, value_tp *v, exec_info *f)
          copy_value_tp(&wu->v, &vu->v, f);
        return;
        /* No new memory for the remaining cases */
+       case REP_wide:                  *w = *v; w->v.wd->refcnt++;       return;
+       case REP_array: case REP_record: *w = *v; w->v.l->refcnt++;       return;
        case REP_process:               *w = *v; w->v.ps->refcnt++;       return;
        case REP_port:                  *w = *v; w->v.p->wprobe.refcnt++; return;
        case REP_wwire: case REP_rwire: *w = *v; w->v.w->refcnt++;        return;
        case REP_type:                  *w = *v; w->v.tp->refcnt++;       return;
        case REP_cnt:                   *w = *v; w->v.c->refcnt++;        return;
+       case REP_packed:                *w = *v; w->v.k->refcnt++;        return;
        default:                        *w = *v;                          return;
      }
  }
 
+extern void unshare_value(value_tp *v, exec_info *f)
+ /* If v is an array or record whose value_list has other references,
+    give v a private copy of the list.  The elements are copied with
+    copy_value_tp, so nested lists remain shared until they are
+    modified in turn.
+ */
+ { int i;
+   value_list *vl, *wl;
+   if (v->rep != REP_array && v->rep != REP_record) return;
+   vl = v->v.l;
+   if (vl->refcnt == 1) return;
+   v->v.l = wl = new_value_list(vl->size, f);
+   for (i = 0; i < vl->size; i++)
+     { copy_value_tp(&wl->vl[i], &vl->vl[i], f); }
+   vl->refcnt--;
+ }
+
+extern void unshare_z(value_tp *v, exec_info *f)
+ /* If v is a REP_z value with other references, give v a private copy */
+ { z_value *vz;
+   if (v->rep != REP_z || v->v.z->refcnt == 1) return;
+   vz = v->v.z;
+   v->v.z = new_z_value(f);
+   mpz_set(v->v.z->z, vz->z);
+   vz->refcnt--;
+ }
+
 extern void alias_value_tp(value_tp *w, value_tp *v, exec_info *f)
  /* Copy v to w, sharing the memory */
  { *w = *v;
    switch (v->rep)
      { case REP_z:                       w->v.z->refcnt++;         return;
+       case REP_wide:                    w->v.wd->refcnt++;        return;
        case REP_array: case REP_record:  w->v.l->refcnt++;         return;
        case REP_union:                   w->v.u->refcnt++;         return;
        case REP_process:                 w->v.ps->refcnt++;        return;
@@ -831,6 +1040,7 @@ extern void alias_value_tp(value_tp *w, value_tp *v, exec_info *f)
        case REP_wwire: case REP_rwire:   w->v.w->refcnt++;         return;
        case REP_type:                    w->v.tp->refcnt++;        return;
        case REP_cnt:                     w->v.c->refcnt++;         return;
+       case REP_packed:                  w->v.k->refcnt++;         return;
        default:                                                    return;
      }
  }
@@ -839,9 +1049,7 @@ extern void copy_and_clear(value_tp *w, value_tp *v, exec_info *f)
  /* Same as: copy_value_tp(w, v, f); clear_value_tp(v, f);
     but more efficient.
  */
- { int i;
-   value_list *vl, *wl;
-   value_union *vu, *wu;
+ { value_union *vu, *wu;
    z_value *vz;
    if (v->rep == REP_z)
      { vz = v->v.z;
@@ -852,21 +1060,6 @@ extern void copy_and_clear(value_tp *w, value_tp *v, exec_info *f)
            copy_value_tp(w, v, f);
          }
      }
-   else if (v->rep == REP_array || v->rep == REP_record)
-     { w->rep = v->rep;
-       vl = v->v.l;
-       if (vl->refcnt == 1)
-         { w->v.l = wl = vl;
-           for (i = 0; i < vl->size; i++)
-             { copy_and_clear(&wl->vl[i], &vl->vl[i], f); }
-         }
-       else
-         { vl->refcnt--; 
-           w->v.l = wl = new_value_list(vl->size, f);
-           for (i = 0; i < vl->size; i++)
-             { copy_value_tp(&wl->vl[i], &vl->vl[i], f); }
-         }
-     }
    else if (v->rep == REP_union)
      { w->rep = REP_union;
        vu = v->v.u;
@@ -889,6 +1082,307 @@ extern void copy_and_clear(value_tp *w, value_tp *v, exec_info *f)
  }
 
 
+/********** packed arrays ****************************************************/
+
+#define NR_WORDS(N) (((N) + LONG_NRBITS - 1) / LONG_NRBITS)
+#define PAGE_IDX(I) ((I) >> PACKED_PAGE_BITS)
+#define PAGE_POS(I) ((I) & (PACKED_PAGE_SIZE - 1))
+
+static long page_len(packed_value *k, long p)
+ /* nr of elements in page p of k */
+ { long n = k->size - (p << PACKED_PAGE_BITS);
+   return n < PACKED_PAGE_SIZE? n : PACKED_PAGE_SIZE;
+ }
+
+static long page_bytes(packed_value *k, long p)
+ /* nr of bytes allocated for page p of k */
+ { long n = page_len(k, p);
+   if (!k->nr_bit) return n * sizeof(value_tp);
+   return (NR_WORDS(n) + NR_WORDS(n * k->nr_bit)) * sizeof(ulong);
+ }
+
+static ulong *new_page(packed_value *k, long p)
+ /* allocate page p of k, with no element values */
+ { ulong *pg;
+   MALLOC(pg, page_bytes(k, p));
+   memset(pg, 0, page_bytes(k, p)); /* also sets value_tp's to REP_none */
+   k->page[p] = pg;
+   return pg;
+ }
+
+static void free_page(packed_value *k, long p, exec_info *f)
+ { value_tp *vp;
+   long j, n;
+   if (!k->page[p]) return;
+   if (!k->nr_bit)
+     { vp = (value_tp*)k->page[p];
+       n = page_len(k, p);
+       for (j = 0; j < n; j++)
+         { clear_value_tp(&vp[j], f); }
+     }
+   free(k->page[p]);
+   k->page[p] = 0;
+ }
+
+static packed_value *new_packed_value
+(long size, int nr_bit, valrep_tp rep, long l, exec_info *f)
+ /* allocate a new packed_value without pages */
+ { packed_value *k;
+   long p;
+   MALLOC(k, sizeof(*k));
+   k->refcnt = 1;
+   k->size = size;
+   k->nr_bit = nr_bit;
+   k->rep = rep;
+   k->l = l;
+   k->nr_page = PAGE_IDX(size - 1) + 1;
+   NEW_ARRAY(k->page, k->nr_page);
+   for (p = 0; p < k->nr_page; p++)
+     { k->page[p] = 0; }
+   return k;
+ }
+
+static void free_packed_value(packed_value *k, exec_info *f)
+ { long p;
+   for (p = 0; p < k->nr_page; p++)
+     { free_page(k, p, f); }
+   free(k->page);
+   free(k);
+ }
+
+static void packed_unshare(value_tp *v, exec_info *f)
+ /* Pre: v is REP_packed.  Give v a private copy of its pages if needed */
+ { packed_value *k = v->v.k, *kk;
+   value_tp *vp, *wp;
+   long p, j, n;
+   if (k->refcnt == 1) return;
+   kk = new_packed_value(k->size, k->nr_bit, k->rep, k->l, f);
+   for (p = 0; p < k->nr_page; p++)
+     { if (!k->page[p]) continue;
+       new_page(kk, p);
+       if (k->nr_bit)
+         { memcpy(kk->page[p], k->page[p], page_bytes(k, p)); }
+       else
+         { vp = (value_tp*)k->page[p];
+           wp = (value_tp*)kk->page[p];
+           n = page_len(k, p);
+           for (j = 0; j < n; j++)
+             { copy_value_tp(&wp[j], &vp[j], f); }
+         }
+     }
+   k->refcnt--;
+   v->v.k = kk;
+ }
+
+extern void packed_get(value_tp *w, value_tp *v, long i, exec_info *f)
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Set w to element i of v (REP_none if it has no value).
+ */
+ { packed_value *k = v->v.k;
+   ulong *pg = k->page[PAGE_IDX(i)], *d;
+   long j = PAGE_POS(i);
+   if (!pg)
+     { w->rep = REP_none;
+       return;
+     }
+   if (!k->nr_bit)
+     { alias_value_tp(w, &((value_tp*)pg)[j], f);
+       return;
+     }
+   if (!(pg[j / LONG_NRBITS] & (1UL << (j % LONG_NRBITS))))
+     { w->rep = REP_none;
+       return;
+     }
+   w->rep = k->rep;
+   d = pg + NR_WORDS(page_len(k, PAGE_IDX(i)));
+   switch (k->nr_bit)
+     { case 1:  w->v.i = (d[j / LONG_NRBITS] >> (j % LONG_NRBITS)) & 1; return;
+       case 8:  w->v.i = k->l + ((unsigned char*)d)[j];  return;
+       default: w->v.i = k->l + ((unsigned short*)d)[j]; return;
+     }
+ }
+
+extern void unpack_value(value_tp *w, value_tp *v, exec_info *f)
+ /* Pre: v is REP_packed.
+    Set w to the same value as an array with a value_list; w may be v.
+ */
+ { packed_value *k = v->v.k;
+   value_list *wl;
+   long i;
+   if (k->size > ARRAY_REP_MAXSIZE)
+     { exec_error(f, f->curr->obj, "Implementation limit exceeded: Using "
+                  "all %ld elements of a sparse array", k->size);
+     }
+   wl = new_value_list(k->size, f);
+   for (i = 0; i < k->size; i++)
+     { packed_get(&wl->vl[i], v, i, f); }
+   if (w == v)
+     { clear_value_tp(v, f); }
+   w->rep = REP_array;
+   w->v.l = wl;
+ }
+
+extern void packed_read(value_tp *w, value_tp *v, exec_info *f)
+ /* Pre: v is REP_packed.  Set w to v, for reading the whole array.
+    This unpacks v, except that a sparse array is shared when evaluating
+    at the debug prompt (so that it can be printed).
+ */
+ { if (v->v.k->size > ARRAY_REP_MAXSIZE &&
+       !IS_SET(f->flags, EXEC_eval_only) &&
+       IS_SET(f->user->flags, USER_debug))
+     { alias_value_tp(w, v, f); }
+   else
+     { unpack_value(w, v, f); }
+ }
+
+static void packed_widen(value_tp *v, exec_info *f)
+ /* Pre: v is REP_packed.
+    Change v to store elements as value_tp, for values that do not fit,
+    or when the elements need an address.
+ */
+ { packed_value *k = v->v.k, *kk;
+   value_tp *wp;
+   long p, j, n;
+   if (!k->nr_bit) return;
+   kk = new_packed_value(k->size, 0, REP_none, 0, f);
+   for (p = 0; p < k->nr_page; p++)
+     { if (!k->page[p]) continue;
+       wp = (value_tp*)new_page(kk, p);
+       n = page_len(k, p);
+       for (j = 0; j < n; j++)
+         { packed_get(&wp[j], v, (p << PACKED_PAGE_BITS) + j, f); }
+     }
+   clear_value_tp(v, f);
+   v->rep = REP_packed;
+   v->v.k = kk;
+ }
+
+extern void packed_set(value_tp *v, long i, value_tp *e, exec_info *f)
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Set element i of v to a copy of e.  If e does not fit in the packed
+    representation, then v is unpacked (or widened, if it is sparse) first.
+ */
+ { packed_value *k = v->v.k;
+   long p = PAGE_IDX(i), j = PAGE_POS(i);
+   ulong *pg, *d, m, x;
+   value_tp *vp;
+   if (k->nr_bit && e->rep && (e->rep != k->rep || e->v.i < k->l ||
+                               e->v.i - k->l >= (1L << k->nr_bit)))
+     { if (k->size <= ARRAY_REP_MAXSIZE)
+         { unpack_value(v, v, f);
+           clear_value_tp(&v->v.l->vl[i], f);
+           copy_value_tp(&v->v.l->vl[i], e, f);
+           return;
+         }
+       packed_widen(v, f);
+     }
+   packed_unshare(v, f);
+   k = v->v.k;
+   pg = k->page[p];
+   if (!pg)
+     { if (!e->rep) return;
+       pg = new_page(k, p);
+     }
+   if (!k->nr_bit)
+     { vp = &((value_tp*)pg)[j];
+       clear_value_tp(vp, f);
+       copy_value_tp(vp, e, f);
+       return;
+     }
+   m = 1UL << (j % LONG_NRBITS);
+   if (!e->rep)
+     { pg[j / LONG_NRBITS] &= ~m;
+       return;
+     }
+   pg[j / LONG_NRBITS] |= m;
+   d = pg + NR_WORDS(page_len(k, p));
+   x = e->v.i - k->l;
+   switch (k->nr_bit)
+     { case 1:
+         if (x) d[j / LONG_NRBITS] |= m;
+         else d[j / LONG_NRBITS] &= ~m;
+       return;
+       case 8:  ((unsigned char*)d)[j] = x;  return;
+       default: ((unsigned short*)d)[j] = x; return;
+     }
+ }
+
+extern value_tp *packed_elem(value_tp *v, long i, exec_info *f)
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Return the address of element i, which is private to v.
+    Used where the element must be identified by its address (strict
+    interference checks).
+ */
+ { packed_value *k;
+   long p = PAGE_IDX(i);
+   packed_widen(v, f);
+   packed_unshare(v, f);
+   k = v->v.k;
+   if (!k->page[p]) new_page(k, p);
+   return &((value_tp*)k->page[p])[PAGE_POS(i)];
+ }
+
+extern void *packed_reval(value_tp *v, long i, exec_info *f)
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Return the address of element i.  If elements are packed, this is
+    f->pkv, set to element i of v; when assigning, element i is then
+    updated from f->pkv by packed_store().
+ */
+ { packed_value *k = v->v.k;
+   clear_value_tp(&f->pkv, f);
+   if (!k->nr_bit)
+     { if (IS_SET(f->flags, EVAL_assign))
+         { return packed_elem(v, i, f); }
+       else if (k->page[PAGE_IDX(i)])
+         { return &((value_tp*)k->page[PAGE_IDX(i)])[PAGE_POS(i)]; }
+       return &f->pkv;
+     }
+   packed_get(&f->pkv, v, i, f);
+   if (IS_SET(f->flags, EVAL_assign))
+     { f->pk = v;
+       f->pk_idx = i;
+     }
+   return &f->pkv;
+ }
+
+extern void packed_store(exec_info *f)
+ /* Complete an assignment to an element of a packed array */
+ { if (!f->pk) return;
+   packed_set(f->pk, f->pk_idx, &f->pkv, f);
+   clear_value_tp(&f->pkv, f);
+   f->pk = 0;
+ }
+
+extern void print_packed_value(value_tp *v, print_info *f)
+ /* Print packed v to f.  Of a sparse array, only the elements that have
+    values are printed, up to PACKED_PRINT_MAX of them.
+ */
+ { packed_value *k = v->v.k;
+   value_tp e;
+   long i, n = 0;
+   int sparse = k->size > ARRAY_REP_MAXSIZE;
+   print_char('[', f);
+   for (i = 0; i < k->size; i++)
+     { if (sparse && !k->page[PAGE_IDX(i)])
+         { i |= PACKED_PAGE_SIZE - 1;
+           continue;
+         }
+       packed_get(&e, v, i, 0);
+       if (sparse && !e.rep) continue;
+       if (n) { print_char(',', f); print_char(' ', f); }
+       if (sparse && n == PACKED_PRINT_MAX)
+         { print_string("...", f);
+           break;
+         }
+       if (sparse) f->pos += var_str_printf(f->s, f->pos, "%ld: ", i);
+       print_value_tp(&e, f);
+       clear_value_tp(&e, 0);
+       n++;
+     }
+   print_char(']', f);
+ }
+
+
 /********** range checks *****************************************************/
 
 static void no_range(expr *x, exec_info *f)
@@ -907,6 +1401,10 @@ extern void range_check(type_spec *tps, value_tp *val, exec_info *f, void *obj)
        return;
      }
    if (!tps) return; /* happens with some generic types */
+   if (val->rep == REP_int && IS_SET(tps->flags, TYPE_bounds))
+     { if (((integer_type*)tps)->lo <= val->v.i &&
+           val->v.i <= ((integer_type*)tps)->hi) return;
+     }
    f->val = val;
    f->err_obj = obj;
    APP_OBJ_VFZ(app_range, tps, f, no_range);
@@ -926,7 +1424,11 @@ static void update_rule(wire_expr_flags val, wire_expr_action u, exec_info *f)
          if (IS_SET(val, WIRE_value)) SET_FLAG(u.act->flags, af);
          else RESET_FLAG(u.act->flags, af);
          if (!IS_SET(u.act->flags, ACTION_check))
-           { llist_prepend(&f->check, u.act);
+           { if (f->nr_check == f->max_check)
+               { f->max_check = f->max_check? 2 * f->max_check : CHECK_LIST_MINSIZE;
+                 REALLOC_ARRAY(f->check, f->max_check);
+               }
+             f->check[f->nr_check++] = u.act;
              SET_FLAG(u.act->flags, ACTION_check);
            }
        return;
@@ -974,6 +1476,9 @@ static void update_rule(wire_expr_flags val, wire_expr_action u, exec_info *f)
          if (IS_SET(val, WIRE_value))
            { clear_value_tp(u.val, f); }
        return;
+       case WIRE_ready:
+         if (u.rdy) ready_update(u.rdy, IS_SET(val, WIRE_value), f);
+       return;
        default:
        return;
      }
@@ -1060,7 +1565,7 @@ static void update_wire_expr(wire_flags val, wire_expr *e, exec_info *f)
 
 extern void write_wire(int val, wire_value *w, exec_info *f)
  /* Pre: w has been run through wire_fix */
- { llist m;
+ { int i;
    wire_expr *e;
    mpz_t time;
    wire_flags old = w->flags;
@@ -1096,11 +1601,9 @@ extern void write_wire(int val, wire_value *w, exec_info *f)
    if (IS_SET(w->flags, WIRE_has_dep))
      { ASSIGN_FLAG(old, w->flags, WIRE_value);
        /* old is now formatted for update_wire_expr */
-       m = w->u.dep;
-       while (!llist_is_empty(&m))
-         { e = llist_head(&m);
+       for (i = w->u.dep.nr - 1; i >= 0; i--)
+         { e = DEP_IDX(&w->u.dep, i);
            update_wire_expr(old, e, f);
-           m = llist_alias_tail(&m);
            f->ecount++;
          }
        run_checks(w, f);
@@ -1111,7 +1614,7 @@ extern void write_wire(int val, wire_value *w, exec_info *f)
 
 extern void update_counter(int dir, counter_value *c, exec_info *f)
  { wire_flags val;
-   llist m;
+   int i;
    if (!dir && !(c->cnt--))
      { exec_error(f, c->err_obj, "Counter value has become negative"); }
    if (dir && (++c->cnt) > MAX_COUNT)
@@ -1119,11 +1622,8 @@ extern void update_counter(int dir, counter_value *c, exec_info *f)
                                  "(missing decrement?)");
      }
    val = dir? WIRE_value : 0;
-   m = c->dep;
-   while (!llist_is_empty(&m))
-     { update_wire_expr(val, llist_head(&m), f);
-       m = llist_alias_tail(&m);
-     }
+   for (i = c->dep.nr - 1; i >= 0; i--)
+     { update_wire_expr(val, DEP_IDX(&c->dep, i), f); }
  }
    
 extern void force_value(value_tp *xval, expr *x, exec_info *f)
@@ -1170,11 +1670,12 @@ extern void force_value(value_tp *xval, expr *x, exec_info *f)
      }
  }
 
-extern void force_value_array(value_tp *xval, type *tp, exec_info *f)
- /* Like the above, but assumes tp is an array type */
+static long array_size(type *tp, long max, exec_info *f)
+ /* Pre: tp is an array type.  Return the nr of elements of tp,
+    which must not exceed max.
+ */
  { array_type *atps;
    value_tp lval, hval, dval;
-   xval->rep = REP_array;
    atps = (array_type*)tp->tps;
    assert(atps->class == CLASS_array_type);
    eval_expr(atps->h, f);
@@ -1187,15 +1688,73 @@ extern void force_value_array(value_tp *xval, type *tp, exec_info *f)
      }
    dval = int_sub(&hval, &lval, f);
    int_simplify(&dval, f);
-   if ((dval.rep == REP_int && hval.v.i > ARRAY_REP_MAXSIZE) ||
-        dval.rep == REP_z)
+   if ((dval.rep == REP_int && dval.v.i >= max) || dval.rep != REP_int)
      { int_inc(&dval, f);
        exec_error(f, tp, "Implementation limit exceeded: Array size "
-                     "%v > %ld", vstr_val, &dval, (long)ARRAY_REP_MAXSIZE);
+                     "%v > %ld", vstr_val, &dval, max);
      }
-   xval->v.l = new_value_list(dval.v.i + 1, f);
+   return dval.v.i + 1;
  }
 
+extern void force_value_array(value_tp *xval, type *tp, exec_info *f)
+ /* Like the above, but assumes tp is an array type */
+ { xval->rep = REP_array;
+   xval->v.l = new_value_list(array_size(tp, ARRAY_REP_MAXSIZE, f), f);
+ }
+
+extern void force_value_packed(value_tp *xval, expr *x, exec_info *f)
+ /* Like force_value, but use a packed_value if x is an array variable
+    of booleans or small integers with at least PACKED_REP_MINSIZE elements,
+    or of booleans or integers with more than ARRAY_REP_MAXSIZE elements.
+ */
+ { type *etp;
+   integer_type *itps;
+   value_tp lval, hval, dval;
+   long size, l = 0;
+   int nr_bit = 0, scalar = 0;
+   if (x->class != CLASS_var_ref || x->tp.kind != TP_array ||
+       IS_SET(x->flags, EXPR_port | EXPR_port_ext | EXPR_wire |
+                        EXPR_counter | EXPR_generic))
+     { force_value(xval, x, f);
+       return;
+     }
+   etp = x->tp.elem.tp;
+   if (etp->kind == TP_bool)
+     { nr_bit = 1; }
+   else if (etp->kind == TP_int)
+     { scalar = 1; }
+   if (scalar && etp->tps && etp->tps->class == CLASS_integer_type)
+     { itps = (integer_type*)etp->tps;
+       eval_expr(itps->h, f);
+       eval_expr(itps->l, f);
+       pop_value(&lval, f);
+       pop_value(&hval, f);
+       dval = int_sub(&hval, &lval, f);
+       int_simplify(&dval, f);
+       if (lval.rep == REP_int && dval.rep == REP_int && dval.v.i < 0x10000)
+         { nr_bit = dval.v.i < 0x100? 8 : 16;
+           l = lval.v.i;
+         }
+       clear_value_tp(&lval, f);
+       clear_value_tp(&hval, f);
+       clear_value_tp(&dval, f);
+     }
+   if (nr_bit) scalar = 1;
+   size = array_size(&x->tp, scalar? SPARSE_REP_MAXSIZE : ARRAY_REP_MAXSIZE, f);
+   if (size > ARRAY_REP_MAXSIZE && !nr_bit)
+     { xval->rep = REP_packed;
+       xval->v.k = new_packed_value(size, 0, REP_none, 0, f);
+       return;
+     }
+   if (!nr_bit || size < PACKED_REP_MINSIZE)
+     { xval->rep = REP_array;
+       xval->v.l = new_value_list(size, f);
+       return;
+     }
+   xval->rep = REP_packed;
+   xval->v.k = new_packed_value(size, nr_bit, nr_bit == 1? REP_bool : REP_int,
+                                l, f);
+ }
 static void no_assign(expr *x, exec_info *f)
  /* called when x has no assign function */
  { error("Internal error: "
@@ -1210,6 +1769,7 @@ extern void assign(expr *x, value_tp *val, exec_info *f)
    if (!val->rep)
      { exec_error(f, x, "Unknown value in assignment to %v", vstr_obj, x); }
    SET_FLAG(f->flags, EVAL_assign);
+   f->pk = 0;
    if (IS_SET(x->flags, EXPR_lvalue))
      { xv = reval_expr(x, f);
        if (IS_SET(x->flags, EXPR_ifrchk))
@@ -1224,6 +1784,7 @@ extern void assign(expr *x, value_tp *val, exec_info *f)
        APP_OBJ_VFZ(app_assign, x, f, no_assign);
        f->val = w;
      }
+   packed_store(f);
    RESET_FLAG(f->flags, EVAL_assign);
  }
 
@@ -1240,10 +1801,30 @@ extern value_tp *connect_expr(void *obj, exec_info *f)
 
 /********** creating wire expressions ***************************************/
 
+/* Every production rule of every instance owns a few wire_exprs, which
+   live until the end of the simulation.  They are carved out of blocks
+   of WIRE_EXPR_BLOCK, rather than paying malloc overhead for each one.
+   Freed wire_exprs (mostly from chp waits, see add_wire_dep) are kept
+   on a free list, linked through u.dep.
+*/
+static wire_expr *we_block, *we_free = 0;
+static int we_block_nr = 0;
+
 extern wire_expr *new_wire_expr(exec_info *f)
  /* Note that refcnt is initially zero */
  { wire_expr *e;
-   NEW(e);
+   if (we_free)
+     { e = we_free;
+       we_free = e->u.dep;
+     }
+   else
+     { if (!we_block_nr)
+         { NEW_ARRAY(we_block, WIRE_EXPR_BLOCK);
+           LEAK(we_block);
+           we_block_nr = WIRE_EXPR_BLOCK;
+         }
+       e = &we_block[--we_block_nr];
+     }
    e->refcnt = 0;
    e->valcnt = 0;
    e->undefcnt = 0;
@@ -1290,6 +1871,8 @@ static wire_expr *_make_wire_expr(expr *x, wire_expr *p, exec_info *f)
    long i, n;
    int compat;
    wire_expr_flags flags;
+   if (wr->class == CLASS_wire_ref)
+     { x = wr->x; }
    if (!IS_SET(x->flags, EXPR_unconst))
      { eval_expr(x, f);
        pop_value(&v, f);
@@ -1302,19 +1885,19 @@ static wire_expr *_make_wire_expr(expr *x, wire_expr *p, exec_info *f)
        pop_value(&v, f);
        assert(v.rep == REP_wwire || v.rep == REP_rwire);
        if (!IS_SET(v.v.w->flags, WIRE_has_dep))
-         { llist_init(&v.v.w->u.dep);
+         { dep_list_init(&v.v.w->u.dep);
            SET_FLAG(v.v.w->flags, WIRE_has_dep);
          }
        if (!p)
          { e = new_wire_expr(f);
            e->flags = WIRE_xor | (v.v.w->flags & WIRE_val_mask);
-           llist_prepend(&v.v.w->u.dep, e);
+           dep_list_add(&v.v.w->u.dep, e);
            e->refcnt++;
          }
        else
          { e = &temp_wire_expr;
            e->flags = v.v.w->flags;
-           llist_prepend(&v.v.w->u.dep, p);
+           dep_list_add(&v.v.w->u.dep, p);
          }
      }
    else if (pe->class == CLASS_prefix_expr)
@@ -1373,13 +1956,71 @@ extern void clear_wire_expr(wire_expr *e, exec_info *f)
    if (!e->refcnt)
      { if (!IS_SET(e->flags, WIRE_action))
          { clear_wire_expr(e->u.dep, f); }
-       free(e);
+       e->u.dep = we_free;
+       we_free = e;
+     }
+ }
+
+extern void dep_list_init(dep_list *d)
+ /* d is empty */
+ { d->nr = 0;
+   d->max = DEP_INLINE;
+ }
+
+extern void dep_list_add(dep_list *d, wire_expr *e)
+ /* add e at the end of d */
+ { wire_expr **v;
+   int i;
+   if (d->max == DEP_INLINE && d->nr < DEP_INLINE)
+     { d->u.s[d->nr++] = e;
+       return;
+     }
+   if (d->nr == d->max)
+     { if (d->max == DEP_INLINE)
+         { NEW_ARRAY(v, 2 * DEP_INLINE);
+           for (i = 0; i < DEP_INLINE; i++)
+             { v[i] = d->u.s[i]; }
+           d->u.v = v;
+         }
+       else
+         { REALLOC_ARRAY(d->u.v, 2 * d->max); }
+       d->max = 2 * d->max;
      }
+   d->u.v[d->nr++] = e;
+ }
+
+extern void dep_list_remove(dep_list *d, int i)
+ /* remove element i of d, replacing it by the last element */
+ { assert(i >= 0 && i < d->nr);
+   d->nr--;
+   if (d->max > DEP_INLINE)
+     { d->u.v[i] = d->u.v[d->nr]; }
+   else
+     { d->u.s[i] = d->u.s[d->nr]; }
+ }
+
+extern int dep_list_extract(dep_list *d, dep_func *g, void *info)
+ /* Remove every element e of d for which g(e, info) is not 0.
+    Return is the nr of elements removed.
+ */
+ { int i, n = 0;
+   for (i = d->nr - 1; i >= 0; i--)
+     { if (g(DEP_IDX(d, i), info))
+         { dep_list_remove(d, i); n++; }
+     }
+   return n;
+ }
+
+extern void dep_list_free(dep_list *d)
+ /* free any memory used by d, d becomes empty */
+ { if (d->max > DEP_INLINE)
+     { free(d->u.v); }
+   dep_list_init(d);
  }
 
 extern void add_wire_dep(wire_value *w, exec_info *f)
  { if (!IS_SET(w->flags, WIRE_has_dep))
-     { llist_init(&w->u.dep);
+     { dep_list_init(&w->u.dep);
        SET_FLAG(w->flags, WIRE_has_dep);
      }
    if (!f->e)
@@ -1392,7 +2033,7 @@ extern void add_wire_dep(wire_value *w, exec_info *f)
      { f->e->flags = WIRE_susp | WIRE_val_dir; }
    f->e->refcnt++;
    f->e->valcnt++;
-   llist_prepend(&w->u.dep, f->e);
+   dep_list_add(&w->u.dep, f->e);
    llist_prepend(&f->curr->dep, w); /* not refcnt'ed */
  }
 
@@ -61,12 +61,13 @@
 
 typedef enum valrep_tp
    { REP_none = 0, /* no value assigned */
-     REP_bool, REP_int, REP_z, REP_symbol, REP_array, REP_record,
+     REP_bool, REP_int, REP_z, REP_wide, REP_symbol, REP_array, REP_record,
      REP_process, REP_port, REP_union, REP_cnt, REP_type,
-     REP_rwire, REP_wwire /* wwire can be written to, rwire can't */
+     REP_rwire, REP_wwire, /* wwire can be written to, rwire can't */
+     REP_packed /* array variable of booleans or small integers */
    } valrep_tp; /* representation */
 
-/* Limits for use of REP_int instead of REP_z */
+/* Limits for use of REP_int instead of REP_wide or REP_z */
 #define MIN_INT_REP LONG_MIN /* -2^n, if long is n+1 bits */
 #define MAX_INT_REP LONG_MAX /* 2^n - 1, if long is n+1 bits */
 #define INT_REP_SIGN LONG_MIN /* sign bit */
@@ -76,7 +77,17 @@ typedef enum valrep_tp
 /* limits to avoid ridiculous operations: */
 #define INT_REP_MAXBITS 10000 /* highest bit position we'll consider */
 #define INT_REP_MAXEXP 2000 /* largest exponent in x^y */
+#define WIDE_REP_NRBITS 256 /* REP_wide for |x| < 2^n, REP_z beyond */
+#define WIDE_REP_NRWORD (WIDE_REP_NRBITS / INT_REP_NRBITS + 1)
+				/* words of a wide_value, incl. a sign word */
+#define WIDE_REP_POOLSIZE 1024 /* max nr of free wide_values kept for reuse */
+#define WIRE_EXPR_BLOCK 1024 /* nr of wire_exprs allocated at once */
 #define ARRAY_REP_MAXSIZE 65536 /* largest array size */
+#define PACKED_REP_MINSIZE 64 /* smallest array variable to pack */
+#define SPARSE_REP_MAXSIZE (1L << 30) /* largest packed array variable */
+#define PACKED_PAGE_BITS 12
+#define PACKED_PAGE_SIZE (1L << PACKED_PAGE_BITS) /* elements per page */
+#define PACKED_PRINT_MAX 16 /* elements printed of a sparse array */
 #define MAX_COUNT 65535 /* maximum counter value */
 
 #define ALLOW_SPLIT_PRS 0 /* allow multiple pr's with the same target */
@@ -87,7 +98,11 @@ typedef struct value_union value_union;
 typedef struct type_value type_value;
 typedef struct wire_value wire_value;
 typedef struct counter_value counter_value;
+typedef struct wire_expr wire_expr;
+typedef struct dep_list dep_list;
 typedef struct z_value z_value;
+typedef struct wide_value wide_value;
+typedef struct packed_value packed_value;
 typedef struct process_state process_state; /* defined in exec.h */
 
 typedef struct value_tp value_tp;
@@ -95,6 +110,7 @@ struct value_tp
    { valrep_tp rep;
      union { long i; // REP_bool, REP_int
              z_value *z; // REP_z (arbitrary size int)
+             wide_value *wd; // REP_wide (fixed size int)
 	     const str *s; // REP_symbol
 	     value_list *l; // REP_array, REP_record
 	     port_value *p; // REP_port
@@ -103,6 +119,7 @@ struct value_tp
 	     counter_value *c; // REP_cnt
 	     process_state *ps; // REP_process
 	     type_value *tp; // REP_type
+	     packed_value *k; // REP_packed
 	   } v;
    };
 
@@ -131,6 +148,42 @@ struct z_value
      mpz_t z; /* gmp.h */
    };
 
+/* Integers that do not fit in a long, but are at least -2^WIDE_REP_NRBITS
+   and less than 2^WIDE_REP_NRBITS, are REP_wide rather than REP_z: two's
+   complement, least significant word first, so that the common operations
+   on wide buses need not go through gmp.  The last word is 0 or ~0.
+   A wide_value is not modified once it has been set, so copies share it.
+*/
+struct wide_value
+   { int refcnt;
+     ulong w[WIDE_REP_NRWORD];
+   };
+
+/* A packed_value replaces the value_list of an array variable whose
+   elements are booleans or integers with a range of at most 2^16 values,
+   storing each element in 1, 8 or 16 bits.  It also represents array
+   variables of booleans or integers with more than ARRAY_REP_MAXSIZE
+   elements (sparse arrays), if need be with value_tp elements.
+   The elements are kept in pages of PACKED_PAGE_SIZE, which are only
+   allocated once an element of the page gets a value.
+
+   A packed_value only occurs in the variable itself: eval_expr() unpacks
+   it when the whole array is read, and reval_array_subscript() accesses
+   single elements through packed_reval().
+*/
+struct packed_value
+   { int refcnt;
+     long size; /* nr of elements */
+     int nr_bit; /* bits per element: 1, 8 or 16; 0 for value_tp elements */
+     valrep_tp rep; /* REP_bool or REP_int, if nr_bit > 0 */
+     long l; /* element i has value l + (stored bits) */
+     long nr_page;
+     ulong **page; /* page[p] is 0 if no element in it has a value, else
+                      (nr_bit > 0) a bit per element that is set iff the
+                      element has a value, followed by the element bits,
+                      or (nr_bit == 0) an array of value_tp */
+   };
+
 FLAGS(wire_flags)
    { FIRST_FLAG(WIRE_value), /* boolean value of the wire */
      NEXT_FLAG(WIRE_undef), /* true if value should be REP_none */
@@ -144,11 +197,30 @@ FLAGS(wire_flags)
      NEXT_FLAG(WIRE_watch), /* print all transitions of this wire */
      NEXT_FLAG(WIRE_reset), /* set if wire is held at its initial value */
      NEXT_FLAG(WIRE_virtual), /* no reference in wframe, use u.dep for debug */
+     NEXT_FLAG(WIRE_pruned), /* value is no longer updated, see prune_wires */
+     NEXT_FLAG(WIRE_bypassed), /* not driven, see wu_procs_bypass */
      NEXT_FLAG(PORT_deadwu), /* set if port is a cancelled wired union */
      NEXT_FLAG(PORT_multiprobe), /* a multiply referenced port value */
      WIRE_val_mask = WIRE_undef | WIRE_value
    };
 
+#define DEP_INLINE 3 /* nr of dependents stored inside a dep_list */
+
+struct dep_list
+   { int nr, max; /* elements are in u.v iff max > DEP_INLINE */
+     union { wire_expr *s[DEP_INLINE];
+             wire_expr **v;
+           } u;
+   };
+/* A dep_list holds the wire_exprs depending on a wire_value or a
+ * counter_value.  Most wires have only a few dependents, which are kept
+ * in the dep_list itself; only larger lists spill to a heap array.
+ * New dependents are added at the end, and dependents are visited from
+ * the end down, so the most recently added dependent is updated first.
+ * Removing element i moves the last element to position i.
+ */
+#define DEP_IDX(D, I) ((D)->max > DEP_INLINE? (D)->u.v[I] : (D)->u.s[I])
+
 struct wire_value
    { int refcnt;
      wire_flags flags;
@@ -156,7 +228,7 @@ struct wire_value
              process_state *wps; /* Used for port value probes */
            };
      union { wire_value *w; /* Used during instantiation */
-             llist dep; /* Used during execution */
+             dep_list dep; /* Used during execution */
            } u;
    };
 
@@ -178,6 +250,7 @@ FLAGS(wire_expr_flags)
      WIRE_xu = WIRE_hu | WIRE_susp, /* force downward transition */
      WIRE_x = WIRE_xu | WIRE_xd, /* force transition to wire_expr value */
      WIRE_vc = WIRE_susp | WIRE_hold, /* clear the referenced value */
+     WIRE_ready = WIRE_pu | WIRE_pd | WIRE_hold, /* update a ready set */
      WIRE_action = WIRE_pu | WIRE_pd | WIRE_susp | WIRE_hold /* is an action */
    };
 
@@ -185,8 +258,6 @@ FLAGS(wire_expr_flags)
 
 typedef struct action action; /* defined in exec.h */
 
-typedef struct wire_expr wire_expr;
-
 typedef union wire_expr_action wire_expr_action;
 union wire_expr_action
    { wire_expr *dep;
@@ -194,6 +265,7 @@ union wire_expr_action
      action *act;
      wire_value *hold;
      value_tp *val;
+     struct ready_guard *rdy; /* 0 once its ready set is freed */
    };
 
 struct wire_expr
@@ -235,9 +307,25 @@ struct wire_expr
 struct counter_value
   { int refcnt, cnt;
     parse_obj *err_obj;
-    llist dep; /* llist(wire_expr) */
+    dep_list dep;
   };
 
+typedef struct port_buffer port_buffer;
+struct port_buffer
+   { int refcnt;
+     long size, head, cnt; /* capacity, index of oldest value, nr values */
+     long delay; /* forward latency, only used if not USER_random */
+     action *fwd; /* raises the receiver's probe once delay has passed */
+     mpz_t *t; /* t[size]: time at which each value becomes visible */
+     value_tp v[1]; /* actually: value_tp v[size]; */
+   };
+/* A port_buffer turns a channel into a native slack channel.  Both ports
+ * of the channel refer to the same buffer, and the probes get a different
+ * meaning: the probe of the sending port is set while there is room in the
+ * buffer, the probe of the receiving port is set while there is a (visible)
+ * value in the buffer.  Communications then complete in a single event.
+ */
+
 struct port_value
    { wire_value wprobe;
      wire_value *wpp; /* wire_value of other port */
@@ -246,6 +334,7 @@ struct port_value
      //process_state *ps; /* process that communicates on this port */
      union_field *dec; /* is this part of a decomposition process? */
      value_tp *nv; /* used for disconnected ports of meta processes */
+     port_buffer *buf; /* non-zero for a native slack channel */
    };
 
 #define PORT_FROM_WPROBE(W) ((port_value*)(W))
@@ -317,6 +406,15 @@ extern void eval_expr(void *obj, struct exec_info *f);
 extern void *reval_expr(void *obj, struct exec_info *f);
  /* Evaluate lvslue expr *obj, return pointer to stored value */
 
+extern value_tp *eval_borrow(void *obj, value_tp *tmp, struct exec_info *f);
+ /* Evaluate expr *obj without taking a reference to it.  Returns either
+    a pointer to the stored value, which must not be changed or kept, or
+    tmp, which then holds the value.  Release with release_borrow().
+ */
+
+extern void release_borrow(value_tp *v, value_tp *tmp, struct exec_info *f);
+ /* Release value v returned by eval_borrow(obj, tmp, f) */
+
 extern void push_value(value_tp *v, struct exec_info *f);
  /* push *v on stack (direct copy: top = *v) */
 
@@ -350,6 +448,23 @@ extern void wire_fix(wire_value **w, struct exec_info *f);
 extern z_value *new_z_value(struct exec_info *f);
  /* allocate a new z_value, with initial value 0 */
 
+extern wide_value *new_wide_value(struct exec_info *f);
+ /* allocate a new wide_value (the words are not initialized) */
+
+extern void wide_get_z(mpz_t z, const ulong *w);
+ /* Set z to the value of the WIDE_REP_NRWORD words w */
+
+extern int wide_set_z(ulong *w, mpz_t z);
+ /* If |z| < 2^WIDE_REP_NRBITS, set the WIDE_REP_NRWORD words w to z and
+    return 1; otherwise return 0.
+ */
+
+extern int wide_tstbit(const ulong *w, long i);
+ /* Return bit i of the WIDE_REP_NRWORD words w */
+
+extern void int_unwide(value_tp *v, struct exec_info *f);
+ /* If v is REP_wide, replace it by the same value as REP_z */
+
 extern type_value *new_type_value(struct exec_info *f);
  /* allocate new type_value */
 
@@ -359,13 +474,23 @@ extern void clear_value_tp(value_tp *v, struct exec_info *f);
  */
 
 extern void copy_value_tp(value_tp *w, value_tp *v, struct exec_info *f);
- /* Copy v to w, allocating new memory */
+ /* Copy v to w, allocating new memory (except for the value_list of
+    an array or record, which is shared copy-on-write)
+ */
 
 extern void copy_and_clear(value_tp *w, value_tp *v, struct exec_info *f);
  /* Same as: copy_value_tp(w, v, f); clear_value_tp(v, f);
     but more efficient.
  */
 
+extern void unshare_value(value_tp *v, struct exec_info *f);
+ /* If the value_list of array or record v is shared, give v a private
+    copy, so that its elements can be modified in place.
+ */
+
+extern void unshare_z(value_tp *v, struct exec_info *f);
+ /* If the z_value of v is shared, give v a private copy */
+
 extern void alias_value_tp(value_tp *w, value_tp *v, struct exec_info *f);
  /* Copy v to w, sharing the memory */
 
@@ -414,6 +539,53 @@ extern void force_value(value_tp *xval, expr *x, struct exec_info *f);
 extern void force_value_array(value_tp *xval, type *tp, struct exec_info *f);
  /* Like the above, but assumes tp is an array type */
 
+extern void force_value_packed(value_tp *xval, expr *x, struct exec_info *f);
+ /* Like force_value, but use a packed_value if x is an array variable
+    of booleans or small integers with at least PACKED_REP_MINSIZE elements.
+ */
+
+extern void packed_get(value_tp *w, value_tp *v, long i, struct exec_info *f);
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Set w to element i of v (REP_none if it has no value).
+ */
+
+extern void packed_set(value_tp *v, long i, value_tp *e, struct exec_info *f);
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Set element i of v to a copy of e.  If e does not fit in the packed
+    representation, then v is unpacked (or widened, if it is sparse) first.
+ */
+
+extern void unpack_value(value_tp *w, value_tp *v, struct exec_info *f);
+ /* Pre: v is REP_packed.
+    Set w to the same value as an array with a value_list; w may be v.
+ */
+
+extern void packed_read(value_tp *w, value_tp *v, struct exec_info *f);
+ /* Pre: v is REP_packed.  Set w to v, for reading the whole array.
+    This unpacks v, except that a sparse array is shared when evaluating
+    at the debug prompt (so that it can be printed).
+ */
+
+extern value_tp *packed_elem(value_tp *v, long i, struct exec_info *f);
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Return the address of element i, which is private to v.
+ */
+
+extern void *packed_reval(value_tp *v, long i, struct exec_info *f);
+ /* Pre: v is REP_packed, 0 <= i < size.
+    Return the address of element i.  If elements are packed, this is
+    f->pkv, set to element i of v; when assigning, element i is then
+    updated from f->pkv by packed_store().
+ */
+
+extern void packed_store(struct exec_info *f);
+ /* Complete an assignment to an element of a packed array */
+
+extern void print_packed_value(value_tp *v, print_info *f);
+ /* Print packed v to f.  Of a sparse array, only the elements that have
+    values are printed, up to PACKED_PRINT_MAX of them.
+ */
+
 extern void assign(expr *x, value_tp *val, struct exec_info *f);
  /* Assign x := val where x is an lvalue.
     Note: you should do a range_check() first.
@@ -453,6 +625,25 @@ extern wire_expr temp_wire_expr;
 
 extern void clear_wire_expr(wire_expr *e, struct exec_info *f);
 
+typedef int dep_func(wire_expr *e, void *info);
+
+extern void dep_list_init(dep_list *d);
+ /* d is empty */
+
+extern void dep_list_add(dep_list *d, wire_expr *e);
+ /* add e at the end of d */
+
+extern void dep_list_remove(dep_list *d, int i);
+ /* remove element i of d, replacing it by the last element */
+
+extern int dep_list_extract(dep_list *d, dep_func *g, void *info);
+ /* Remove every element e of d for which g(e, info) is not 0.
+    Return is the nr of elements removed.
+ */
+
+extern void dep_list_free(dep_list *d);
+ /* free any memory used by d, d becomes empty */
+
 extern void add_wire_dep(wire_value *w, struct exec_info *f);
  /* set up w to reschedule f->curr upon the changing of w's value */
 
@@ -339,6 +339,7 @@ static void wire_var_fix(value_tp *v, int write, exec_info *f)
  { int i;
    switch (v->rep)
      { case REP_array:
+         unshare_value(v, f);
          for (i = 0; i < v->v.l->size; i++)
            { wire_var_fix(&v->v.l->vl[i], write, f); }
        return;
@@ -358,10 +359,11 @@ static void counter_var_fix(value_tp *v, exec_info *f)
    void *x = f->err_obj;
    switch (v->rep)
      { case REP_array:
+         unshare_value(v, f);
          for (i = 0; i < v->v.l->size; i++)
            { counter_var_fix(&v->v.l->vl[i], f); }
        return;
-       case REP_z:
+       case REP_z: case REP_wide:
          exec_error(f, x, "Counter value %v is too large", vstr_val, v);
        case REP_int:
          if (v->v.i > MAX_COUNT)
@@ -467,7 +469,7 @@ static int exec_property_decl(property_decl *x, exec_info *f)
    if (x->z)
      { eval_expr(x->z, f);
        pop_value(&zval, f);
-       if (zval.rep == REP_z)
+       if (zval.rep == REP_z || zval.rep == REP_wide)
          { exec_error(f, x, "Initial value %v is too large", vstr_val, &zval); }
        declare_property(x->id, zval.v.i, f->prop);
      }